@@ -0,0 +1,59 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "associate.h"
+#include "scenario.h"
+
+namespace
+{
+
+// n contacts observed every second with 3 m position noise, plots in
+// shuffled order; warm-up scans confirm the tracks before timing.
+void BM_AssociateScan(benchmark::State& state)
+{
+    const std::size_t n = static_cast<std::size_t>(state.range(0));
+    std::vector<Vec2> pos, vel;
+    make_contacts(n, pos, vel);
+
+    std::mt19937 rng(7);
+    std::normal_distribution<double> noise(0.0, 3.0);
+    std::vector<Plot> plots(n);
+    double time = 0.0;
+
+    auto make_scan = [&]()
+    {
+        for (std::size_t i = 0; i < n; ++i)
+            plots[i] = Plot{ pos[i].x + vel[i].x * time + noise(rng),
+                             pos[i].y + vel[i].y * time + noise(rng) };
+        std::shuffle(plots.begin(), plots.end(), rng);
+    };
+
+    Associator assoc;
+    std::vector<PlotAssignment> out;
+    for (int k = 0; k < 5; ++k, time += 1.0)
+    {
+        make_scan();
+        assoc.process_scan(time, plots, out);
+    }
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        make_scan();
+        state.ResumeTiming();
+
+        assoc.process_scan(time, plots, out);
+        benchmark::DoNotOptimize(out.data());
+        time += 1.0;
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.counters["tracks"] = static_cast<double>(assoc.tracks().size());
+    state.counters["spawned"] = static_cast<double>(assoc.stats().spawned);
+}
+
+} // namespace
+
+BENCHMARK(BM_AssociateScan)->RangeMultiplier(4)->Range(256, 16384)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,124 @@
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <vector>
+
+#include "cpa.h"
+#include "cpa_prob.h"
+#include "scenario.h"
+
+namespace
+{
+
+void BM_ComputeCpa(benchmark::State& state)
+{
+    const std::size_t n = static_cast<std::size_t>(state.range(0));
+    std::vector<Vec2> pos, vel;
+    make_contacts(n, pos, vel);
+    const Vec2 own_pos{0.0, 0.0};
+    const Vec2 own_vel = course_to_velocity(20.0, 30.0);
+
+    std::vector<CpaResult> out(n);
+    for (auto _ : state)
+    {
+        for (std::size_t i = 0; i < n; ++i)
+            out[i] = compute_cpa(own_pos, own_vel, pos[i], vel[i]);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(n));
+}
+
+void BM_ComputeCpaBatch(benchmark::State& state)
+{
+    const std::size_t n = static_cast<std::size_t>(state.range(0));
+    std::vector<Vec2> pos, vel;
+    make_contacts(n, pos, vel);
+    const Vec2 own_pos{0.0, 0.0};
+    const Vec2 own_vel = course_to_velocity(20.0, 30.0);
+
+    std::vector<double> x(n), y(n), vx(n), vy(n);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        x[i] = pos[i].x;  y[i] = pos[i].y;
+        vx[i] = vel[i].x; vy[i] = vel[i].y;
+    }
+
+    CpaResultBlock out;
+    for (auto _ : state)
+    {
+        compute_cpa_batch(own_pos, own_vel, x.data(), y.data(), vx.data(), vy.data(), n, out);
+        benchmark::DoNotOptimize(out.tcpa.data());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(n));
+}
+
+// converged CV filter covariance
+StateCov typical_cov()
+{
+    StateCov c;
+    c.p00 = c.p11 = 9.0;
+    c.p02 = c.p13 = 1.5;
+    c.p22 = c.p33 = 0.6;
+    return c;
+}
+
+// Per-scan screening: args = contacts, near. With near = 1 every contact is
+// moved onto the danger disc boundary so the quadrature path always runs.
+void BM_CollisionProbability(benchmark::State& state)
+{
+    const std::size_t n = static_cast<std::size_t>(state.range(0));
+    std::vector<Vec2> pos, vel;
+    make_contacts(n, pos, vel);
+    const Vec2 own_pos{0.0, 0.0};
+    const Vec2 own_vel = course_to_velocity(20.0, 30.0);
+    const StateCov cov = typical_cov();
+
+    if (state.range(1))
+    {
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            CpaResult r = compute_cpa(own_pos, own_vel, pos[i], vel[i]);
+            const double t = r.tcpa < 0.0 ? 0.0 : (r.tcpa > TCPA_THRESHOLD_SECONDS ? TCPA_THRESHOLD_SECONDS : r.tcpa);
+            const double dx = pos[i].x + (vel[i].x - own_vel.x) * t;
+            const double dy = pos[i].y + (vel[i].y - own_vel.y) * t;
+            const double d = std::hypot(dx, dy);
+            if (d > 0.0)
+            {
+                const double k = CPA_THRESHOLD_METERS / d;
+                pos[i].x = pos[i].x - dx + dx * k;
+                pos[i].y = pos[i].y - dy + dy * k;
+            }
+        }
+    }
+
+    std::vector<double> out(n);
+    for (auto _ : state)
+    {
+        for (std::size_t i = 0; i < n; ++i)
+            out[i] = collision_probability(own_pos, own_vel, pos[i], vel[i], cov);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(n));
+}
+
+// Monte-Carlo reference for one contact on the disc edge, arg = samples
+void BM_CollisionProbabilityMc(benchmark::State& state)
+{
+    const std::size_t samples = static_cast<std::size_t>(state.range(0));
+    const Vec2 own_pos{0.0, 0.0};
+    const Vec2 own_vel{0.0, 0.0};
+    const Vec2 pos{50.0, -100.0};
+    const Vec2 vel{0.0, 5.0};
+    const StateCov cov = typical_cov();
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(collision_probability_mc(own_pos, own_vel, pos, vel, cov, samples));
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(samples));
+}
+
+} // namespace
+
+BENCHMARK(BM_ComputeCpa)->Arg(1000)->Arg(100000);
+BENCHMARK(BM_ComputeCpaBatch)->Arg(1000)->Arg(100000);
+BENCHMARK(BM_CollisionProbability)->Args({5000, 0})->Args({5000, 1});
+BENCHMARK(BM_CollisionProbabilityMc)->Arg(100000);
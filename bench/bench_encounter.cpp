@@ -0,0 +1,46 @@
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include "encounter.h"
+#include "scenario.h"
+
+namespace
+{
+
+void BM_EncounterBrute(benchmark::State& state)
+{
+    std::vector<Vec2> pos, vel;
+    make_contacts(static_cast<std::size_t>(state.range(0)), pos, vel);
+    std::vector<EncounterPair> pairs;
+
+    for (auto _ : state)
+    {
+        screen_encounters_brute(pos, vel, pairs);
+        benchmark::DoNotOptimize(pairs.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.counters["pairs"] = static_cast<double>(pairs.size());
+}
+
+void BM_EncounterGrid(benchmark::State& state)
+{
+    std::vector<Vec2> pos, vel;
+    make_contacts(static_cast<std::size_t>(state.range(0)), pos, vel);
+    std::vector<EncounterPair> pairs;
+    EncounterStats stats;
+
+    for (auto _ : state)
+    {
+        screen_encounters_grid(pos, vel, pairs, &stats);
+        benchmark::DoNotOptimize(pairs.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.counters["pairs"] = static_cast<double>(pairs.size());
+    state.counters["candidates"] = static_cast<double>(stats.candidate_pairs);
+}
+
+} // namespace
+
+BENCHMARK(BM_EncounterBrute)->RangeMultiplier(4)->Range(256, 16384)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_EncounterGrid)->RangeMultiplier(4)->Range(256, 16384)->Unit(benchmark::kMillisecond);
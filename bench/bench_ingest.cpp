@@ -0,0 +1,98 @@
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "nmea.h"
+#include "scenario.h"
+#include "spsc_queue.h"
+
+namespace
+{
+
+// Radar sentences for n contacts, as the replayer would send them.
+std::vector<std::string> make_ttm(std::size_t n)
+{
+    std::vector<Vec2> pos, vel;
+    make_contacts(n, pos, vel);
+    std::vector<std::string> out;
+    for (std::size_t i = 0; i < n; ++i)
+        out.push_back(format_ttm(static_cast<int>(i), "T" + std::to_string(i), 3600.0 + i,
+                                 pos[i].x, pos[i].y, 7.5, 123.4));
+    return out;
+}
+
+void BM_DecodeTtm(benchmark::State& state)
+{
+    const std::vector<std::string> s = make_ttm(1024);
+    NmeaDecoder dec;
+    ContactReport r;
+    std::size_t i = 0;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(dec.decode(s[i++ & 1023], 0.0, r));
+        benchmark::DoNotOptimize(r.x);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_DecodeAivdm(benchmark::State& state)
+{
+    // class A position report (type 1) and class B (type 18)
+    const std::string s[2] = {
+        "!AIVDM,1,1,,B,177KQJ5000G?tO`K>RA1wUbN0TKH,0*5C",
+        "!AIVDM,1,1,,B,B5NJ;PP005l4ot5Isbl03wsUkP06,0*75",
+    };
+    NmeaDecoder dec;
+    dec.set_origin(37.8, -122.4);
+    ContactReport r;
+    std::size_t i = 0;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(dec.decode(s[i++ & 1], 0.0, r));
+        benchmark::DoNotOptimize(r.x);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// Reports pushed by one thread and drained in batches by the benchmark
+// thread, as between the UDP receiver and the tracker.
+void BM_SpscQueue(benchmark::State& state)
+{
+    constexpr std::size_t TOTAL = 1 << 20;
+    const std::size_t drain = static_cast<std::size_t>(state.range(0));
+    std::vector<ContactReport> batch(drain);
+
+    for (auto _ : state)
+    {
+        SpscQueue<ContactReport> q(4096);
+        std::thread producer([&q]()
+        {
+            ContactReport r{};
+            for (std::size_t i = 0; i < TOTAL; ++i)
+            {
+                r.time = static_cast<double>(i);
+                while (!q.try_push(r)) std::this_thread::yield();
+            }
+        });
+
+        std::size_t got = 0;
+        double sum = 0.0;
+        while (got < TOTAL)
+        {
+            std::size_t n = q.pop_n(batch.data(), drain);
+            for (std::size_t k = 0; k < n; ++k) sum += batch[k].time;
+            got += n;
+        }
+        producer.join();
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(TOTAL));
+}
+
+} // namespace
+
+BENCHMARK(BM_DecodeTtm);
+BENCHMARK(BM_DecodeAivdm);
+BENCHMARK(BM_SpscQueue)->Arg(1)->Arg(64)->Unit(benchmark::kMillisecond)->UseRealTime();
@@ -0,0 +1,81 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdio>
+#include <string>
+
+#include "io.h"
+#include "scenario.h"
+#include "thread_pool.h"
+#include "track_file.h"
+
+namespace
+{
+
+ScenarioConfig io_config(const benchmark::State& state)
+{
+    ScenarioConfig cfg;
+    cfg.tracks  = static_cast<std::size_t>(state.range(0));
+    cfg.samples = static_cast<std::size_t>(state.range(1));
+    return cfg;
+}
+
+std::string csv_name(const ScenarioConfig& cfg)
+{
+    return "cpa_bench_" + std::to_string(cfg.tracks) + "x" + std::to_string(cfg.samples) + ".csv";
+}
+
+void BM_LoadCsv(benchmark::State& state)
+{
+    ScenarioConfig cfg = io_config(state);
+    std::string path = write_scenario_csv(cfg, csv_name(cfg));
+
+    for (auto _ : state)
+    {
+        TrackSeries series;
+        load_timeseries_from_csv(path, series);
+        benchmark::DoNotOptimize(series.series.data());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(cfg.tracks * cfg.samples));
+    std::remove(path.c_str());
+}
+
+void BM_LoadCsvParallel(benchmark::State& state)
+{
+    ScenarioConfig cfg = io_config(state);
+    std::string path = write_scenario_csv(cfg, csv_name(cfg));
+    ThreadPool pool(0);
+
+    for (auto _ : state)
+    {
+        TrackSeries series;
+        load_timeseries_from_csv_parallel(path, series, pool);
+        benchmark::DoNotOptimize(series.series.data());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(cfg.tracks * cfg.samples));
+    state.counters["threads"] = pool.size();
+    std::remove(path.c_str());
+}
+
+void BM_LoadTrackFile(benchmark::State& state)
+{
+    ScenarioConfig cfg = io_config(state);
+    TrackSeries src;
+    make_scenario(cfg, src);
+    std::string path = bench_temp_path(csv_name(cfg) + ".cpatrk");
+    write_track_file(path, src);
+
+    for (auto _ : state)
+    {
+        TrackSeries series;
+        load_track_file(path, series);
+        benchmark::DoNotOptimize(series.series.data());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(cfg.tracks * cfg.samples));
+    std::remove(path.c_str());
+}
+
+} // namespace
+
+BENCHMARK(BM_LoadCsv)->Args({100, 1000})->Args({1000, 1000})->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_LoadCsvParallel)->Args({100, 1000})->Args({1000, 1000})->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_LoadTrackFile)->Args({100, 1000})->Args({1000, 1000})->Unit(benchmark::kMillisecond);
@@ -0,0 +1,241 @@
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <vector>
+
+#include "kalman.h"
+#include "imm.h"
+#include "kalman_bank.h"
+#include "pipeline.h"
+#include "scenario.h"
+#include "smoother.h"
+#include "thread_pool.h"
+
+namespace
+{
+
+void BM_KalmanPredict(benchmark::State& state)
+{
+    KalmanFilter2D kf;
+    kf.init(100.0, 50.0, -5.0, 0.0);
+    for (auto _ : state)
+    {
+        kf.predict(1.0);
+        benchmark::DoNotOptimize(kf.P);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_KalmanUpdate(benchmark::State& state)
+{
+    KalmanFilter2D kf;
+    kf.init(100.0, 50.0, -5.0, 0.0);
+    double z = 100.0;
+    for (auto _ : state)
+    {
+        kf.update(z, 50.0);
+        z += 0.001;
+        benchmark::DoNotOptimize(kf.x);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// one predict + update per motion model, target moving on a slow circle
+template <class Model>
+void BM_KalmanModelStep(benchmark::State& state)
+{
+    KalmanFilter<Model> kf;
+    kf.init(100.0, 0.0, 0.0, 5.0);
+    double t = 0.0;
+    for (auto _ : state)
+    {
+        t += 1.0;
+        kf.predict(1.0);
+        kf.update(100.0 * std::cos(0.05 * t), 100.0 * std::sin(0.05 * t));
+        benchmark::DoNotOptimize(kf.x);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// filter_track over one scenario: args = tracks, samples, noise [m]
+void BM_KalmanTracks(benchmark::State& state)
+{
+    ScenarioConfig cfg;
+    cfg.tracks    = static_cast<std::size_t>(state.range(0));
+    cfg.samples   = static_cast<std::size_t>(state.range(1));
+    cfg.noise_std = static_cast<double>(state.range(2));
+    TrackSeries series;
+    make_scenario(cfg, series);
+
+    ThreadPool pool(1);
+    std::vector<TrackState> out;
+    for (auto _ : state)
+    {
+        filter_tracks(series, pool, out);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(series.num_rows()));
+}
+
+// same, with the steady-state gain fast path
+void BM_KalmanTracksSteady(benchmark::State& state)
+{
+    ScenarioConfig cfg;
+    cfg.tracks    = static_cast<std::size_t>(state.range(0));
+    cfg.samples   = static_cast<std::size_t>(state.range(1));
+    cfg.noise_std = static_cast<double>(state.range(2));
+    TrackSeries series;
+    make_scenario(cfg, series);
+
+    ThreadPool pool(1);
+    std::vector<TrackState> out;
+    for (auto _ : state)
+    {
+        filter_tracks(series, pool, out, true);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(series.num_rows()));
+}
+
+// one predict + update once the filter runs on the constant gain
+void BM_KalmanSteadyStep(benchmark::State& state)
+{
+    SteadyGainCache<ConstantVelocity> gains;
+    KalmanFilter2D kf;
+    kf.set_gain_cache(&gains);
+    kf.init(100.0, 50.0, -5.0, 0.0);
+    double z = 100.0;
+    while (!kf.is_steady())
+    {
+        kf.predict(1.0);
+        kf.update(z -= 5.0, 50.0);
+    }
+    for (auto _ : state)
+    {
+        kf.predict(1.0);
+        kf.update(z -= 5.0, 50.0);
+        benchmark::DoNotOptimize(kf.x);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_KalmanBankTracks(benchmark::State& state)
+{
+    ScenarioConfig cfg;
+    cfg.tracks    = static_cast<std::size_t>(state.range(0));
+    cfg.samples   = static_cast<std::size_t>(state.range(1));
+    cfg.noise_std = static_cast<double>(state.range(2));
+    TrackSeries series;
+    make_scenario(cfg, series);
+
+    std::vector<TrackState> out;
+    for (auto _ : state)
+    {
+        filter_tracks_bank(series, out);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(series.num_rows()));
+    state.SetLabel(kalman_bank_isa());
+}
+
+// one predict + update of every track in the bank
+void BM_KalmanBankStep(benchmark::State& state)
+{
+    const std::size_t n = static_cast<std::size_t>(state.range(0));
+    KalmanBank bank;
+    bank.resize(n);
+    for (std::size_t i = 0; i < n; ++i)
+        bank.init(i, static_cast<double>(i), 0.0, 1.0, 0.0);
+
+    std::vector<double> dt(n, 1.0), zx(n), zy(n, 0.0);
+    for (std::size_t i = 0; i < n; ++i) zx[i] = static_cast<double>(i) + 1.0;
+
+    for (auto _ : state)
+    {
+        bank.predict(dt.data());
+        bank.update(zx.data(), zy.data());
+        benchmark::DoNotOptimize(bank.x.data());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(n));
+    state.SetLabel(kalman_bank_isa());
+}
+
+// IMM over the same scenarios; compare items/s with BM_KalmanTracks and
+// BM_KalmanBankTracks for the cost per track update
+void BM_ImmTracks(benchmark::State& state)
+{
+    ScenarioConfig cfg;
+    cfg.tracks    = static_cast<std::size_t>(state.range(0));
+    cfg.samples   = static_cast<std::size_t>(state.range(1));
+    cfg.noise_std = static_cast<double>(state.range(2));
+    TrackSeries series;
+    make_scenario(cfg, series);
+
+    std::vector<TrackState> out;
+    for (auto _ : state)
+    {
+        filter_tracks_imm(series, out);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(series.num_rows()));
+    state.SetLabel(kalman_bank_isa());
+}
+
+// one IMM step of every track
+void BM_ImmStep(benchmark::State& state)
+{
+    const std::size_t n = static_cast<std::size_t>(state.range(0));
+    ImmBank imm;
+    imm.resize(n);
+    for (std::size_t i = 0; i < n; ++i)
+        imm.init(i, static_cast<double>(i), 0.0, 1.0, 0.0);
+
+    std::vector<double> dt(n, 1.0), zx(n), zy(n, 0.0);
+    for (std::size_t i = 0; i < n; ++i) zx[i] = static_cast<double>(i) + 1.0;
+
+    for (auto _ : state)
+    {
+        imm.step(dt.data(), zx.data(), zy.data());
+        benchmark::DoNotOptimize(imm.est.x.data());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(n));
+    state.SetLabel(kalman_bank_isa());
+}
+
+// smooth_tracks (forward filter, RTS backward pass, CPA timeline) over
+// 100 tracks x 1000 samples; arg = lag in steps, 0 = full batch
+void BM_SmoothTracks(benchmark::State& state)
+{
+    ScenarioConfig cfg;
+    cfg.tracks  = 100;
+    cfg.samples = 1000;
+    TrackSeries series;
+    make_scenario(cfg, series);
+
+    SmootherConfig sc;
+    sc.lag = static_cast<std::size_t>(state.range(0));
+    ThreadPool pool(1);
+    std::vector<SmoothedTrack> out;
+    for (auto _ : state)
+    {
+        smooth_tracks(series, pool, Vec2{0.0, 0.0}, Vec2{5.0, 5.0}, sc, out);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(series.num_rows()));
+}
+
+} // namespace
+
+BENCHMARK(BM_KalmanPredict);
+BENCHMARK(BM_KalmanUpdate);
+BENCHMARK_TEMPLATE(BM_KalmanModelStep, ConstantVelocity);
+BENCHMARK_TEMPLATE(BM_KalmanModelStep, ConstantAcceleration);
+BENCHMARK_TEMPLATE(BM_KalmanModelStep, CoordinatedTurn);
+BENCHMARK(BM_KalmanTracks)->Args({100, 1000, 3})->Args({1000, 100, 3})->Args({1000, 100, 30});
+BENCHMARK(BM_KalmanTracksSteady)->Args({100, 1000, 3})->Args({1000, 100, 3})->Args({1000, 100, 30});
+BENCHMARK(BM_KalmanSteadyStep);
+BENCHMARK(BM_KalmanBankTracks)->Args({100, 1000, 3})->Args({1000, 100, 3})->Args({1000, 100, 30});
+BENCHMARK(BM_KalmanBankStep)->Arg(64)->Arg(1024)->Arg(16384);
+BENCHMARK(BM_ImmTracks)->Args({100, 1000, 3})->Args({1000, 100, 3})->Args({1000, 100, 30});
+BENCHMARK(BM_ImmStep)->Arg(64)->Arg(1024)->Arg(16384);
+BENCHMARK(BM_SmoothTracks)->Arg(0)->Arg(5)->Arg(20)->Unit(benchmark::kMillisecond);
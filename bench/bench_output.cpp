@@ -0,0 +1,136 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "instrument.h"
+#include "json_writer.h"
+#include "pipeline.h"
+#include "radar.h"
+#include "scenario.h"
+#include "thread_pool.h"
+
+namespace
+{
+
+struct OutputFixture
+{
+    TrackSeries series;
+    std::vector<CpaResult> results;
+    std::vector<Vec2> positions;
+    std::vector<Vec2> velocities;
+    Vec2 own_pos{0.0, 0.0};
+    Vec2 own_vel = course_to_velocity(20.0, 30.0);
+
+    OutputFixture(std::size_t tracks, std::size_t samples)
+    {
+        ScenarioConfig cfg;
+        cfg.tracks  = tracks;
+        cfg.samples = samples;
+        make_scenario(cfg, series);
+
+        ThreadPool pool(1);
+        std::vector<TrackState> states;
+        filter_tracks(series, pool, states);
+        for (const auto& st : states)
+        {
+            positions.push_back(st.pos);
+            velocities.push_back(st.vel);
+            results.push_back(compute_cpa(own_pos, own_vel, st.pos, st.vel));
+        }
+    }
+};
+
+void BM_WriteJson(benchmark::State& state)
+{
+    OutputFixture f(static_cast<std::size_t>(state.range(0)), static_cast<std::size_t>(state.range(1)));
+    std::string path = bench_temp_path("cpa_bench_out.json");
+    CoutSilencer quiet;
+
+    for (auto _ : state)
+        write_json(path, f.series, f.results, f.positions, f.velocities, f.own_pos, f.own_vel);
+
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(f.series.num_rows()));
+    std::remove(path.c_str());
+}
+
+void BM_AsciiRadar(benchmark::State& state)
+{
+    OutputFixture f(static_cast<std::size_t>(state.range(0)), 2);
+    CoutSilencer quiet;
+
+    for (auto _ : state)
+        print_ascii_radar(f.positions, f.results, f.own_pos);
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// Reused renderer, full frame each iteration.
+void BM_RadarFrame(benchmark::State& state)
+{
+    OutputFixture f(static_cast<std::size_t>(state.range(0)), 2);
+    RadarRenderer radar;
+    CoutSilencer quiet;
+
+    for (auto _ : state)
+    {
+        radar.draw(f.positions, f.results, f.own_pos);
+        radar.render(std::cout);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// Terminal mode at a fixed range, targets moving 1 s per frame.
+void BM_RadarDiff(benchmark::State& state)
+{
+    OutputFixture f(static_cast<std::size_t>(state.range(0)), 2);
+    RadarConfig cfg;
+    cfg.size = 81;
+    cfg.range = 6000.0;
+    RadarRenderer radar(cfg);
+    CoutSilencer quiet;
+
+    const std::size_t n = f.positions.size();
+    std::vector<double> x(n), y(n);
+    std::vector<std::uint8_t> risk(n);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        x[i] = f.positions[i].x;
+        y[i] = f.positions[i].y;
+        risk[i] = f.results[i].collision_risk;
+    }
+
+    for (auto _ : state)
+    {
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            x[i] += f.velocities[i].x;
+            y[i] += f.velocities[i].y;
+        }
+        radar.draw(n, x.data(), y.data(), risk.data(), f.own_pos);
+        radar.render_diff(std::cout);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// Cost of one timed scope with recording off (range 0) and on (range 1).
+void BM_ScopedTimer(benchmark::State& state)
+{
+    instr::set_enabled(state.range(0) != 0);
+    for (auto _ : state)
+    {
+        CPA_TIMED_SCOPE(StreamUpdate);
+        benchmark::ClobberMemory();
+    }
+    instr::set_enabled(false);
+    state.SetItemsProcessed(state.iterations());
+}
+
+} // namespace
+
+BENCHMARK(BM_WriteJson)->Args({100, 1000})->Args({1000, 100})->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_AsciiRadar)->Arg(10)->Arg(1000)->Arg(10000);
+BENCHMARK(BM_RadarFrame)->Arg(10)->Arg(1000)->Arg(10000);
+BENCHMARK(BM_RadarDiff)->Arg(1000)->Arg(10000);
+BENCHMARK(BM_ScopedTimer)->Arg(0)->Arg(1);
@@ -0,0 +1,84 @@
+#include "scenario.h"
+
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <random>
+
+void make_scenario(const ScenarioConfig& cfg, TrackSeries& out)
+{
+    out = TrackSeries{};
+    std::mt19937 rng(cfg.seed);
+    std::uniform_real_distribution<double> coord(-cfg.area_half_width, cfg.area_half_width);
+    std::uniform_real_distribution<double> speed(0.0, cfg.max_speed);
+    std::uniform_real_distribution<double> course(0.0, 360.0);
+    std::normal_distribution<double> noise(0.0, cfg.noise_std > 0.0 ? cfg.noise_std : 1.0);
+
+    for (std::size_t i = 0; i < cfg.tracks; ++i)
+    {
+        auto& seq = out.track("T" + std::to_string(i));
+        TrackId id = static_cast<TrackId>(i);
+
+        double x0 = coord(rng), y0 = coord(rng);
+        double sp = speed(rng), crs = course(rng);
+        Vec2 v = course_to_velocity(sp, crs);
+
+        seq.reserve(cfg.samples);
+        for (std::size_t k = 0; k < cfg.samples; ++k)
+        {
+            double t = static_cast<double>(k) * cfg.dt;
+            double nx = cfg.noise_std > 0.0 ? noise(rng) : 0.0;
+            double ny = cfg.noise_std > 0.0 ? noise(rng) : 0.0;
+            seq.push_back(Measurement{ t, id, x0 + v.x * t + nx, y0 + v.y * t + ny, sp, crs });
+        }
+    }
+
+    out.sort_by_name();
+}
+
+std::string bench_temp_path(const std::string& name)
+{
+    return (std::filesystem::temp_directory_path() / name).string();
+}
+
+std::string write_scenario_csv(const ScenarioConfig& cfg, const std::string& name)
+{
+    TrackSeries series;
+    make_scenario(cfg, series);
+
+    std::string path = bench_temp_path(name);
+    std::ofstream out(path);
+    out << "time,id,x,y,speed,course\n";
+
+    char buf[160];
+    for (std::size_t k = 0; k < cfg.samples; ++k)
+    {
+        for (TrackId id = 0; id < series.size(); ++id)
+        {
+            const Measurement& m = series.series[id][k];
+            int len = std::snprintf(buf, sizeof(buf), "%.3f,%s,%.3f,%.3f,%.3f,%.3f\n",
+                                    m.time, series.ids.name(id).c_str(),
+                                    m.x, m.y, m.speed, m.course_deg);
+            out.write(buf, len);
+        }
+    }
+    return path;
+}
+
+void make_contacts(std::size_t n, std::vector<Vec2>& pos, std::vector<Vec2>& vel,
+                   std::uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    const double half = 0.5 * std::sqrt(static_cast<double>(n) * 1.0e5);
+    std::uniform_real_distribution<double> coord(-half, half);
+    std::uniform_real_distribution<double> speed(-12.0, 12.0);
+
+    pos.resize(n);
+    vel.resize(n);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        pos[i] = Vec2{coord(rng), coord(rng)};
+        vel[i] = Vec2{speed(rng), speed(rng)};
+    }
+}
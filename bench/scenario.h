@@ -0,0 +1,54 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#include "cpa.h"
+#include "io.h"
+
+// Synthetic traffic for the benchmarks: straight-line tracks with
+// Gaussian position noise, sampled at a fixed interval.
+struct ScenarioConfig
+{
+    std::size_t tracks{100};
+    std::size_t samples{100};      // per track
+    double dt{1.0};                // sample interval [s]
+    double noise_std{3.0};         // position noise [m]
+    double area_half_width{5000.0};
+    double max_speed{12.0};        // [m/s]
+    std::uint32_t seed{42};
+};
+
+// Tracks named "T0".."T<n-1>", rows time-ordered.
+void make_scenario(const ScenarioConfig& cfg, TrackSeries& out);
+
+// Write as time,id,x,y,speed,course CSV, interleaved by time like a
+// real recording. Returns the path (under the temp directory).
+std::string write_scenario_csv(const ScenarioConfig& cfg, const std::string& name);
+
+// n contacts at ~1 per 0.1 km^2 (a busy approach), 0..12 m/s per axis.
+void make_contacts(std::size_t n, std::vector<Vec2>& pos, std::vector<Vec2>& vel,
+                   std::uint32_t seed = 42);
+
+// Path under the system temp directory.
+std::string bench_temp_path(const std::string& name);
+
+// Sends std::cout to a null buffer while alive.
+class CoutSilencer
+{
+public:
+    CoutSilencer() : saved_(std::cout.rdbuf(&null_)) {}
+    ~CoutSilencer() { std::cout.rdbuf(saved_); }
+
+private:
+    struct NullBuf : std::streambuf
+    {
+        int overflow(int c) override { return c; }
+        std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+    };
+    NullBuf null_;
+    std::streambuf* saved_;
+};
@@ -0,0 +1,384 @@
+#include "associate.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string>
+
+namespace
+{
+
+inline std::int64_t cell_of(double v, double inv_cell)
+{
+    return static_cast<std::int64_t>(std::floor(v * inv_cell));
+}
+
+inline std::uint64_t cell_key(std::int64_t cx, std::int64_t cy)
+{
+    return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(cx)) << 32)
+         | static_cast<std::uint32_t>(cy);
+}
+
+// min-heap on distance
+struct Farther
+{
+    template <class E>
+    bool operator()(const E& a, const E& b) const { return a.dist > b.dist; }
+};
+
+} // namespace
+
+void SparseAssignment::solve(std::size_t rows,
+                             std::size_t cols,
+                             const std::uint32_t* row_start,
+                             const std::uint32_t* col,
+                             const double* cost,
+                             double miss_cost,
+                             std::vector<std::int32_t>& row_to_col)
+{
+    // columns [0, cols) are real, cols + r is the "unassigned" column of row r
+    const std::size_t total = cols + rows;
+    const double inf = std::numeric_limits<double>::infinity();
+
+    u_.assign(rows, 0.0);
+    v_.assign(total, 0.0);
+    owner_.assign(total, -1);
+    pred_.resize(total);
+    dist_.resize(total);
+    seen_.assign(total, 0);
+    done_.assign(total, 0);
+    row_to_col.assign(rows, -1);
+
+    auto relax = [&](std::uint32_t i, std::uint32_t j, double d)
+    {
+        if (!seen_[j])
+        {
+            seen_[j] = 1;
+            dist_[j] = inf;
+            touched_.push_back(j);
+        }
+        if (!done_[j] && d < dist_[j])
+        {
+            dist_[j] = d;
+            pred_[j] = static_cast<std::int32_t>(i);
+            heap_.push_back(Entry{ d, j });
+            std::push_heap(heap_.begin(), heap_.end(), Farther{});
+        }
+    };
+
+    // relax all edges of row i reached at distance base
+    auto expand = [&](std::uint32_t i, double base)
+    {
+        for (std::uint32_t e = row_start[i]; e < row_start[i + 1]; ++e)
+            relax(i, col[e], base + cost[e] - u_[i] - v_[col[e]]);
+        const std::uint32_t miss = static_cast<std::uint32_t>(cols + i);
+        relax(i, miss, base + miss_cost - u_[i] - v_[miss]);
+    };
+
+    for (std::uint32_t f = 0; f < rows; ++f)
+    {
+        touched_.clear();
+        scanned_.clear();
+        heap_.clear();
+
+        expand(f, 0.0);
+
+        // its own miss column is always free, so a free column is found
+        std::uint32_t end = 0;
+        double delta = 0.0;
+        while (!heap_.empty())
+        {
+            std::pop_heap(heap_.begin(), heap_.end(), Farther{});
+            Entry top = heap_.back();
+            heap_.pop_back();
+            if (done_[top.col] || top.dist > dist_[top.col]) continue;
+
+            done_[top.col] = 1;
+            if (owner_[top.col] < 0)
+            {
+                end = top.col;
+                delta = top.dist;
+                break;
+            }
+            scanned_.push_back(top.col);
+            expand(static_cast<std::uint32_t>(owner_[top.col]), top.dist);
+        }
+
+        // keep reduced costs nonnegative and those of matched edges zero
+        for (std::uint32_t j : scanned_)
+        {
+            double shift = delta - dist_[j];
+            v_[j] -= shift;
+            u_[owner_[j]] += shift;
+        }
+        u_[f] += delta;
+
+        // flip the path back to f
+        for (std::uint32_t j = end;;)
+        {
+            std::int32_t i = pred_[j];
+            std::int32_t prev = row_to_col[i];
+            owner_[j] = i;
+            row_to_col[i] = static_cast<std::int32_t>(j);
+            if (static_cast<std::uint32_t>(i) == f) break;
+            j = static_cast<std::uint32_t>(prev);
+        }
+
+        for (std::uint32_t j : touched_)
+        {
+            seen_[j] = 0;
+            done_[j] = 0;
+        }
+    }
+
+    for (auto& c : row_to_col)
+        if (c >= static_cast<std::int32_t>(cols)) c = -1;
+}
+
+Associator::Associator(const AssociationConfig& cfg)
+    : cfg_(cfg)
+{
+}
+
+void Associator::gate(const std::vector<Plot>& plots)
+{
+    const std::size_t n = tracks_.size();
+    edges_.clear();
+    if (n == 0 || plots.empty()) return;
+
+    // innovation covariance S = HPH^T + R and the gate radius along its
+    // major axis
+    // a track may move this far until the latest plot of the window
+    double max_dt = 0.0;
+    for (const Plot& p : plots) max_dt = std::max(max_dt, p.dt);
+
+    s00_.resize(n); s01_.resize(n); s11_.resize(n); radius_.resize(n);
+    double max_radius = 0.0;
+    for (std::size_t k = 0; k < n; ++k)
+    {
+        const KalmanFilter2D& kf = tracks_[k].kf;
+        const double a = kf.P[0][0] + kf.R[0][0];
+        const double b = kf.P[0][1] + kf.R[0][1];
+        const double c = kf.P[1][1] + kf.R[1][1];
+        const double h = 0.5 * (a - c);
+        const double lmax = 0.5 * (a + c) + std::sqrt(h * h + b * b);
+        s00_[k] = a; s01_[k] = b; s11_[k] = c;
+        radius_[k] = std::sqrt(cfg_.gate * lmax) + std::hypot(kf.getVx(), kf.getVy()) * max_dt;
+        max_radius = std::max(max_radius, radius_[k]);
+    }
+
+    // pitch ~ the median gate, but no track spans more than ~17x17 cells
+    median_.assign(radius_.begin(), radius_.end());
+    std::nth_element(median_.begin(), median_.begin() + n / 2, median_.end());
+    const double cell = std::max({ 2.0 * median_[n / 2], max_radius / 8.0, 1.0 });
+    const double inv_cell = 1.0 / cell;
+
+    cells_.clear();
+    for (std::size_t k = 0; k < n; ++k)
+    {
+        const double px = tracks_[k].kf.getX(), py = tracks_[k].kf.getY();
+        const double r = radius_[k];
+        std::int64_t cx0 = cell_of(px - r, inv_cell), cx1 = cell_of(px + r, inv_cell);
+        std::int64_t cy0 = cell_of(py - r, inv_cell), cy1 = cell_of(py + r, inv_cell);
+        for (std::int64_t cx = cx0; cx <= cx1; ++cx)
+            for (std::int64_t cy = cy0; cy <= cy1; ++cy)
+                cells_.push_back(CellEntry{ cell_key(cx, cy), static_cast<std::uint32_t>(k) });
+    }
+    std::sort(cells_.begin(), cells_.end(),
+              [](const CellEntry& l, const CellEntry& r)
+              { return l.key != r.key ? l.key < r.key : l.track < r.track; });
+
+    for (std::size_t p = 0; p < plots.size(); ++p)
+    {
+        const std::uint64_t key = cell_key(cell_of(plots[p].x, inv_cell),
+                                           cell_of(plots[p].y, inv_cell));
+        auto it = std::lower_bound(cells_.begin(), cells_.end(), key,
+                                   [](const CellEntry& e, std::uint64_t k) { return e.key < k; });
+        for (; it != cells_.end() && it->key == key; ++it)
+        {
+            const std::uint32_t k = it->track;
+            ++stats_.candidate_pairs;
+
+            const KalmanFilter2D& kf = tracks_[k].kf;
+            const double dx = plots[p].x - (kf.getX() + kf.getVx() * plots[p].dt);
+            const double dy = plots[p].y - (kf.getY() + kf.getVy() * plots[p].dt);
+            const double det = s00_[k] * s11_[k] - s01_[k] * s01_[k];
+            if (det <= 0.0) continue;
+            const double nis = (s11_[k] * dx * dx - 2.0 * s01_[k] * dx * dy + s00_[k] * dy * dy) / det;
+            if (nis < cfg_.gate)
+                edges_.push_back(Edge{ k, static_cast<std::uint32_t>(p), nis });
+        }
+    }
+    stats_.gated_pairs += edges_.size();
+}
+
+void Associator::process_scan(double time,
+                              const std::vector<Plot>& plots,
+                              std::vector<PlotAssignment>& out)
+{
+    ++stats_.scans;
+    stats_.plots += plots.size();
+
+    for (AssocTrack& t : tracks_)
+    {
+        double dt = time - t.last_time;
+        if (dt < 0) dt = 0.0;
+        t.kf.predict(dt);
+        t.last_time = time;
+    }
+
+    gate(plots);
+
+    // CSR by track; edges were produced in plot order, which stays
+    const std::size_t n = tracks_.size();
+    row_start_.assign(n + 1, 0);
+    for (const Edge& e : edges_) ++row_start_[e.track + 1];
+    for (std::size_t k = 0; k < n; ++k) row_start_[k + 1] += row_start_[k];
+    col_.resize(edges_.size());
+    cost_.resize(edges_.size());
+    fill_.assign(row_start_.begin(), row_start_.end() - 1);
+    for (const Edge& e : edges_)
+    {
+        std::uint32_t at = fill_[e.track]++;
+        col_[at] = e.plot;
+        cost_[at] = e.nis;
+    }
+
+    solver_.solve(n, plots.size(), row_start_.data(), col_.data(), cost_.data(),
+                  cfg_.gate, row_to_col_);
+
+    out.resize(plots.size());
+    plot_track_.assign(plots.size(), -1);
+    for (std::size_t k = 0; k < n; ++k)
+    {
+        AssocTrack& t = tracks_[k];
+        const std::int32_t p = row_to_col_[k];
+        if (p < 0)
+        {
+            if (cfg_.scan_period > 0.0 && time - t.last_hit < 0.5 * cfg_.scan_period)
+                ++stats_.not_due;
+            else
+                ++t.misses;
+            continue;
+        }
+
+        if (plots[p].dt > 0.0)
+        {
+            t.kf.predict(plots[p].dt);
+            t.last_time = time + plots[p].dt;
+        }
+        t.kf.update(plots[p].x, plots[p].y);
+        t.last_hit = time + plots[p].dt;
+        ++t.hits;
+        t.misses = 0;
+        if (!t.confirmed && t.hits >= cfg_.confirm_hits)
+        {
+            t.confirmed = true;
+            ++stats_.confirmed;
+        }
+        plot_track_[p] = static_cast<std::int32_t>(k);
+        out[p] = PlotAssignment{ t.label, Vec2{ t.kf.getVx(), t.kf.getVy() } };
+        ++stats_.assigned;
+    }
+
+    // drop tentative tracks on their first miss, confirmed ones after
+    // max_misses in a row
+    for (std::size_t k = 0; k < tracks_.size(); )
+    {
+        const AssocTrack& t = tracks_[k];
+        bool drop = t.confirmed ? t.misses >= cfg_.max_misses : t.misses > 0;
+        if (!drop)
+        {
+            ++k;
+            continue;
+        }
+        tracks_[k] = tracks_.back();
+        tracks_.pop_back();
+        ++stats_.deleted;
+    }
+
+    for (std::size_t p = 0; p < plots.size(); ++p)
+    {
+        if (plot_track_[p] >= 0) continue;
+
+        AssocTrack t;
+        t.kf.init(plots[p].x, plots[p].y, 0.0, 0.0);
+        t.label = next_label_++;
+        t.last_time = time + plots[p].dt;
+        t.last_hit = t.last_time;
+        t.hits = 1;
+        t.confirmed = cfg_.confirm_hits <= 1;
+        if (t.confirmed) ++stats_.confirmed;
+        tracks_.push_back(t);
+        ++stats_.spawned;
+
+        out[p] = PlotAssignment{ t.label, Vec2{ 0.0, 0.0 } };
+    }
+}
+
+void associate_series(const TrackSeries& plots,
+                      TrackSeries& out,
+                      const AssociationConfig& cfg,
+                      AssociationStats* stats)
+{
+    std::vector<const Measurement*> rows;
+    rows.reserve(plots.num_rows());
+    for (const auto& seq : plots.series)
+        for (const Measurement& m : seq) rows.push_back(&m);
+    std::stable_sort(rows.begin(), rows.end(),
+                     [](const Measurement* a, const Measurement* b) { return a->time < b->time; });
+
+    Associator assoc(cfg);
+    std::vector<Plot> scan;
+    std::vector<PlotAssignment> labels;
+    std::vector<std::vector<Measurement>> history;  // by label
+    std::vector<unsigned char> confirmed;           // by label, ever
+
+    const double period = cfg.scan_period;
+    for (std::size_t begin = 0; begin < rows.size(); )
+    {
+        // [time, time + period), or one timestamp
+        const double first = rows[begin]->time;
+        const double time = period > 0.0 ? std::floor(first / period) * period : first;
+        const double end_time = period > 0.0 ? time + period : first;
+        std::size_t end = begin + 1;
+        while (end < rows.size() &&
+               (period > 0.0 ? rows[end]->time < end_time : rows[end]->time == first))
+            ++end;
+
+        scan.clear();
+        for (std::size_t r = begin; r < end; ++r)
+            scan.push_back(Plot{ rows[r]->x, rows[r]->y, rows[r]->time - time });
+
+        assoc.process_scan(time, scan, labels);
+
+        history.resize(assoc.labels());
+        confirmed.resize(assoc.labels(), 0);
+        for (std::size_t p = 0; p < scan.size(); ++p)
+        {
+            const PlotAssignment& a = labels[p];
+            double speed = std::hypot(a.vel.x, a.vel.y);
+            double course = std::atan2(a.vel.y, a.vel.x) * 180.0 / M_PI;
+            if (course < 0) course += 360.0;
+            history[a.label].push_back(Measurement{ time + scan[p].dt, a.label,
+                                                    scan[p].x, scan[p].y, speed, course });
+        }
+        for (const AssocTrack& t : assoc.tracks())
+            if (t.confirmed) confirmed[t.label] = 1;
+
+        begin = end;
+    }
+
+    out = TrackSeries{};
+    for (TrackId label = 0; label < history.size(); ++label)
+    {
+        if (!confirmed[label]) continue;
+        std::vector<Measurement>& seq = out.track("A" + std::to_string(label + 1));
+        seq = std::move(history[label]);
+    }
+    for (TrackId id = 0; id < out.size(); ++id)
+        for (Measurement& m : out.series[id]) m.id = id;
+    out.sort_by_name();
+
+    if (stats) *stats = assoc.stats();
+}
@@ -0,0 +1,169 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "cpa.h"
+#include "io.h"
+#include "kalman.h"
+
+// Measurement-to-track association for unlabeled radar plots.
+//
+// Every scan, each live track is predicted to the scan time and gated
+// against the plots by the normalized innovation squared (NIS) of its
+// KalmanFilter2D. Gating goes through a uniform grid over the tracks' gate
+// boxes, so only nearby (track, plot) pairs are scored. The gated pairs
+// form a sparse cost graph solved for the global nearest neighbour
+// assignment (minimum total NIS, a missed track costing the gate).
+// Unassigned plots start tentative tracks; a track is confirmed after
+// confirm_hits updates, and dropped after one miss while tentative or
+// max_misses consecutive misses once confirmed.
+//
+// The plots of one radar sweep are not simultaneous. With a scan_period,
+// a scan is the window [time, time + scan_period) and every plot carries
+// its offset into it: gating extrapolates each track to the plot's own
+// time, and an assigned track is updated at that time. A track whose last
+// plot lies less than half a period before the window could not have come
+// round again yet, so it is not charged a miss.
+
+struct Plot
+{
+    double x;
+    double y;
+    double dt{0.0};  // [s] after the scan time
+};
+
+struct AssociationConfig
+{
+    double gate{13.8};         // NIS gate (chi-square, 2 dof, 99.9 %)
+    unsigned confirm_hits{3};  // updates before a track is confirmed
+    unsigned max_misses{3};    // consecutive missed scans of a confirmed track
+    double scan_period{0.0};   // [s] sweep window; 0 = each timestamp is a scan
+};
+
+// One live track. `label` stays with the track for its whole life and is
+// never reused.
+struct AssocTrack
+{
+    KalmanFilter2D kf;
+    TrackId label{0};
+    double last_time{0.0};   // filter time
+    double last_hit{0.0};    // time of the last plot
+    unsigned hits{0};
+    unsigned misses{0};
+    bool confirmed{false};
+};
+
+// Outcome of one plot of a scan.
+struct PlotAssignment
+{
+    TrackId label;   // track it updated, possibly just spawned
+    Vec2 vel;        // filtered velocity after the update
+};
+
+struct AssociationStats
+{
+    std::size_t scans{0};
+    std::size_t plots{0};
+    std::size_t assigned{0};         // plots that updated an existing track
+    std::size_t candidate_pairs{0};  // pairs inside the grid cell query
+    std::size_t gated_pairs{0};      // pairs inside the NIS gate
+    std::size_t spawned{0};
+    std::size_t confirmed{0};
+    std::size_t deleted{0};
+    std::size_t not_due{0};          // unassigned tracks the window could not cover
+};
+
+// Minimum-cost assignment on a sparse bipartite graph in which every row
+// may also stay unassigned at cost miss_cost. Successive shortest
+// augmenting paths (Dijkstra with potentials) that only visit columns
+// reachable through gated edges, so the work follows the size of the
+// clusters and not rows x columns. Buffers are kept between calls.
+class SparseAssignment
+{
+public:
+    // Edges of row r are [row_start[r], row_start[r+1]) in col / cost,
+    // with 0 <= cost < miss_cost. row_to_col[r] receives the column of
+    // row r, or -1 when it stays unassigned.
+    void solve(std::size_t rows,
+               std::size_t cols,
+               const std::uint32_t* row_start,
+               const std::uint32_t* col,
+               const double* cost,
+               double miss_cost,
+               std::vector<std::int32_t>& row_to_col);
+
+private:
+    struct Entry
+    {
+        double dist;
+        std::uint32_t col;
+    };
+
+    std::vector<double> u_, v_, dist_;
+    std::vector<std::int32_t> owner_, pred_;
+    std::vector<unsigned char> seen_, done_;
+    std::vector<std::uint32_t> touched_, scanned_;
+    std::vector<Entry> heap_;
+};
+
+class Associator
+{
+public:
+    explicit Associator(const AssociationConfig& cfg = AssociationConfig{});
+
+    // Associate the plots of one scan starting at `time` (not earlier than
+    // the previous scan; plot i was taken at time + plots[i].dt). out[i]
+    // receives the track plot i went to.
+    void process_scan(double time,
+                      const std::vector<Plot>& plots,
+                      std::vector<PlotAssignment>& out);
+
+    const std::vector<AssocTrack>& tracks() const { return tracks_; }
+    const AssociationStats& stats() const { return stats_; }
+
+    // Number of labels handed out so far (live and deleted tracks).
+    std::size_t labels() const { return next_label_; }
+
+private:
+    struct CellEntry
+    {
+        std::uint64_t key;
+        std::uint32_t track;
+    };
+
+    struct Edge
+    {
+        std::uint32_t track;
+        std::uint32_t plot;
+        double nis;
+    };
+
+    void gate(const std::vector<Plot>& plots);
+
+    AssociationConfig cfg_;
+    std::vector<AssocTrack> tracks_;
+    TrackId next_label_{0};
+    AssociationStats stats_;
+
+    // per-scan scratch, reused
+    std::vector<double> s00_, s01_, s11_, radius_, median_;
+    std::vector<CellEntry> cells_;
+    std::vector<Edge> edges_;
+    std::vector<std::uint32_t> row_start_, fill_, col_;
+    std::vector<double> cost_;
+    std::vector<std::int32_t> row_to_col_;
+    std::vector<std::int32_t> plot_track_;
+    SparseAssignment solver_;
+};
+
+// Rebuild track ids for a recording whose id column is not trusted: all
+// rows of `plots` are merged in time order and grouped into scans, by
+// windows of cfg.scan_period (like ScanConfig::period) or per distinct
+// timestamp when it is 0, and the Associator labels them. Tracks that were ever confirmed
+// become the series of `out`, named "A<label>", with speed and course
+// taken from the filtered velocity.
+void associate_series(const TrackSeries& plots,
+                      TrackSeries& out,
+                      const AssociationConfig& cfg = AssociationConfig{},
+                      AssociationStats* stats = nullptr);
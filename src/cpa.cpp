@@ -1,4 +1,5 @@
 #include "cpa.h"
+#include "simd.h"
 
 CpaResult compute_cpa(
     const Vec2& own_pos,
@@ -33,3 +34,88 @@ CpaResult compute_cpa(
 
     return CpaResult{ cpa_dist, tcpa, risk, closing, true };
 }
+
+const char* cpa_status_text(const CpaResult& r)
+{
+    if (!r.valid)              return "No relative motion";
+    if (!r.closing)            return "Diverging";
+    if (r.collision_risk)      return "COLLISION RISK";
+    return "Safe";
+}
+
+void CpaResultBlock::resize(std::size_t n)
+{
+    cpa_distance.resize(n);
+    tcpa.resize(n);
+    collision_risk.resize(n);
+    closing.resize(n);
+    valid.resize(n);
+}
+
+CpaResult CpaResultBlock::at(std::size_t i) const
+{
+    return CpaResult{ cpa_distance[i], tcpa[i],
+                      collision_risk[i] != 0, closing[i] != 0, valid[i] != 0 };
+}
+
+namespace
+{
+
+template <class S>
+inline void cpa_lanes(const Vec2& own_pos, const Vec2& own_vel,
+                      const double* tx, const double* ty,
+                      const double* tvx, const double* tvy,
+                      std::size_t i, CpaResultBlock& out)
+{
+    using V = typename S::V;
+
+    const V rx = S::load(tx + i) - S::set1(own_pos.x);
+    const V ry = S::load(ty + i) - S::set1(own_pos.y);
+
+    const V vx_rel = S::load(tvx + i) - S::set1(own_vel.x);
+    const V vy_rel = S::load(tvy + i) - S::set1(own_vel.y);
+
+    const V v2 = vx_rel*vx_rel + vy_rel*vy_rel;
+    const typename S::M valid = S::ge(v2, S::set1(1e-9));
+
+    // no relative motion: tcpa = 0, so the CPA is the current range
+    const V dot  = rx*vx_rel + ry*vy_rel;
+    const V tcpa = S::select(valid, -dot / S::select(valid, v2, S::set1(1.0)), S::set1(0.0));
+
+    const V rx_cpa = rx + vx_rel * tcpa;
+    const V ry_cpa = ry + vy_rel * tcpa;
+    const V d2 = rx_cpa*rx_cpa + ry_cpa*ry_cpa;
+
+    const typename S::M closing = S::land(valid, S::ge(tcpa, S::set1(0.0)));
+    const typename S::M risk = S::land(
+        closing,
+        S::land(S::lt(d2, S::set1(CPA_THRESHOLD_METERS * CPA_THRESHOLD_METERS)),
+                S::lt(tcpa, S::set1(TCPA_THRESHOLD_SECONDS))));
+
+    S::store(&out.cpa_distance[i], S::sqrt(d2));
+    S::store(&out.tcpa[i], tcpa);
+    S::store_mask(&out.collision_risk[i], risk);
+    S::store_mask(&out.closing[i], closing);
+    S::store_mask(&out.valid[i], valid);
+}
+
+} // namespace
+
+void compute_cpa_batch(
+    const Vec2& own_pos,
+    const Vec2& own_vel,
+    const double* tgt_x,
+    const double* tgt_y,
+    const double* tgt_vx,
+    const double* tgt_vy,
+    std::size_t n,
+    CpaResultBlock& out)
+{
+    if (out.size() < n) out.resize(n);
+
+    std::size_t i = 0;
+    for (; i + simd::Wide::width <= n; i += simd::Wide::width)
+        cpa_lanes<simd::Wide>(own_pos, own_vel, tgt_x, tgt_y, tgt_vx, tgt_vy, i, out);
+    for (; i < n; ++i)
+        cpa_lanes<simd::Scalar>(own_pos, own_vel, tgt_x, tgt_y, tgt_vx, tgt_vy, i, out);
+}
@@ -1,6 +1,9 @@
 #pragma once
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <vector>
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
@@ -35,3 +38,35 @@ CpaResult compute_cpa(
     const Vec2& own_vel,
     const Vec2& tgt_pos,
     const Vec2& tgt_vel);
+
+// Human-readable status used by the console table and stream output.
+const char* cpa_status_text(const CpaResult& r);
+
+// Structure-of-arrays CPA results for a batch of targets.
+// Flags are stored as 0 / 1 bytes.
+struct CpaResultBlock
+{
+    std::vector<double> cpa_distance;
+    std::vector<double> tcpa;
+    std::vector<std::uint8_t> collision_risk;
+    std::vector<std::uint8_t> closing;
+    std::vector<std::uint8_t> valid;
+
+    void resize(std::size_t n);
+    std::size_t size() const { return tcpa.size(); }
+    CpaResult at(std::size_t i) const;
+};
+
+// CPA/TCPA of n targets (contiguous x, y, vx, vy arrays) against own ship.
+// Branchless SIMD kernel (see simd.h); thresholds are tested on squared
+// distance and the only square root is the reported cpa_distance.
+// Results are written to out[0..n), which is resized if needed.
+void compute_cpa_batch(
+    const Vec2& own_pos,
+    const Vec2& own_vel,
+    const double* tgt_x,
+    const double* tgt_y,
+    const double* tgt_vx,
+    const double* tgt_vy,
+    std::size_t n,
+    CpaResultBlock& out);
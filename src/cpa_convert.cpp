@@ -0,0 +1,94 @@
+#include <cerrno>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+
+#include "io.h"
+#include "thread_pool.h"
+#include "track_file.h"
+
+// Whole-argument unsigned integer in [lo, hi]; rejects signs, spaces and
+// trailing characters, which strtoul would quietly accept or wrap.
+static bool parse_count(const char* s, std::size_t lo, std::size_t hi, std::size_t& out)
+{
+    if (*s < '0' || *s > '9') return false;
+    errno = 0;
+    char* end = nullptr;
+    unsigned long long v = std::strtoull(s, &end, 10);
+    if (errno == ERANGE || *end != '\0' || v < lo || v > hi) return false;
+    out = static_cast<std::size_t>(v);
+    return true;
+}
+
+static void print_usage()
+{
+    std::cerr << "Usage: cpa_convert <csv_path> <out.cpatrk> [--threads N]\n";
+    std::cerr << "\nConverts a time-series CSV (time,id,x,y,speed,course) into the\n"
+              << "binary columnar track format read by cpa_risk.\n";
+}
+
+int main(int argc, char* argv[])
+{
+    std::string csv_path;
+    std::string out_path;
+    unsigned num_threads = 1;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--threads")
+        {
+            if (i + 1 >= argc)
+            {
+                std::cerr << "--threads requires a value\n";
+                return 1;
+            }
+            std::size_t n = 0;
+            if (!parse_count(argv[++i], 0, 1024, n))
+            {
+                std::cerr << "--threads must be between 0 and 1024\n";
+                return 1;
+            }
+            num_threads = static_cast<unsigned>(n);
+        }
+        else if (arg.rfind("--", 0) == 0)
+        {
+            std::cerr << "Unknown option: " << arg << "\n";
+            print_usage();
+            return 1;
+        }
+        else if (csv_path.empty())
+            csv_path = arg;
+        else if (out_path.empty())
+            out_path = arg;
+        else
+        {
+            std::cerr << "Unexpected extra argument: " << arg << "\n";
+            print_usage();
+            return 1;
+        }
+    }
+
+    if (csv_path.empty() || out_path.empty())
+    {
+        print_usage();
+        return 1;
+    }
+
+    ThreadPool pool(num_threads);
+
+    TrackSeries series;
+    bool loaded = (pool.size() > 1)
+        ? load_timeseries_from_csv_parallel(csv_path, series, pool)
+        : load_timeseries_from_csv(csv_path, series);
+    if (!loaded)
+        return 1;
+
+    if (!write_track_file(out_path, series))
+        return 1;
+
+    std::cout << "Converted " << series.num_rows() << " rows, " << series.size()
+              << " tracks to " << out_path << "\n";
+    return 0;
+}
@@ -0,0 +1,184 @@
+#include "cpa_prob.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace
+{
+
+// Gauss-Legendre nodes and weights on [-1, 1]
+struct GaussLegendre
+{
+    static constexpr int n = 16;
+    double x[n];
+    double w[n];
+
+    GaussLegendre()
+    {
+        for (int i = 0; i < n; ++i)
+        {
+            double z = std::cos(M_PI * (i + 0.75) / (n + 0.5));
+            double dp = 1.0;
+            for (int it = 0; it < 100; ++it)
+            {
+                double p0 = 1.0, p1 = z;
+                for (int k = 2; k <= n; ++k)
+                {
+                    double p2 = ((2.0 * k - 1.0) * z * p1 - (k - 1.0) * p0) / k;
+                    p0 = p1;
+                    p1 = p2;
+                }
+                dp = n * (z * p1 - p0) / (z * z - 1.0);
+                double dz = p1 / dp;
+                z -= dz;
+                if (std::fabs(dz) < 1e-15) break;
+            }
+            x[i] = z;
+            w[i] = 2.0 / ((1.0 - z * z) * dp * dp);
+        }
+    }
+};
+
+const GaussLegendre& gauss_legendre()
+{
+    static const GaussLegendre gl;
+    return gl;
+}
+
+// Relative position at the clamped CPA instant and its 2x2 covariance.
+struct CpaGaussian
+{
+    double t;
+    double dx, dy;
+    double sxx, sxy, syy;
+};
+
+CpaGaussian cpa_gaussian(const Vec2& own_pos, const Vec2& own_vel,
+                         const Vec2& tgt_pos, const Vec2& tgt_vel,
+                         const StateCov& c, double horizon)
+{
+    const double rx = tgt_pos.x - own_pos.x, ry = tgt_pos.y - own_pos.y;
+    const double vx = tgt_vel.x - own_vel.x, vy = tgt_vel.y - own_vel.y;
+    const double v2 = vx * vx + vy * vy;
+
+    double t = (v2 < 1e-6) ? 0.0 : -(rx * vx + ry * vy) / v2;
+    t = std::clamp(t, 0.0, horizon);
+
+    CpaGaussian g;
+    g.t = t;
+    g.dx = rx + vx * t;
+    g.dy = ry + vy * t;
+    g.sxx = c.p00 + 2.0 * t * c.p02 + t * t * c.p22;
+    g.sxy = c.p01 + t * (c.p03 + c.p12) + t * t * c.p23;
+    g.syy = c.p11 + 2.0 * t * c.p13 + t * t * c.p33;
+    return g;
+}
+
+} // namespace
+
+double collision_probability(const Vec2& own_pos,
+                             const Vec2& own_vel,
+                             const Vec2& tgt_pos,
+                             const Vec2& tgt_vel,
+                             const StateCov& cov,
+                             double radius,
+                             double horizon)
+{
+    const CpaGaussian g = cpa_gaussian(own_pos, own_vel, tgt_pos, tgt_vel, cov, horizon);
+
+    // principal axes, u along the larger variance
+    const double half_tr = 0.5 * (g.sxx + g.syy);
+    const double disc = std::sqrt(0.25 * (g.sxx - g.syy) * (g.sxx - g.syy) + g.sxy * g.sxy);
+    const double l1 = std::max(half_tr + disc, 1e-12);
+    const double l2 = std::max(half_tr - disc, 1e-12);
+    const double s1 = std::sqrt(l1), s2 = std::sqrt(l2);
+
+    // nothing of the Gaussian reaches the disc, or all of it is inside
+    const double dist = std::hypot(g.dx, g.dy);
+    if (dist - radius > 6.0 * s1) return 0.0;
+    if (radius - dist > 6.0 * s1) return 1.0;
+
+    const double th = 0.5 * std::atan2(2.0 * g.sxy, g.sxx - g.syy);
+    const double ct = std::cos(th), st = std::sin(th);
+    const double u0 =  ct * g.dx + st * g.dy;
+    const double w0 = -st * g.dx + ct * g.dy;
+
+    // integrate over u where both the disc and the Gaussian live
+    const double lo = std::max(-radius, u0 - 6.0 * s1);
+    const double hi = std::min( radius, u0 + 6.0 * s1);
+    if (!(hi > lo)) return 0.0;
+
+    const GaussLegendre& gl = gauss_legendre();
+    const double mid = 0.5 * (hi + lo), half = 0.5 * (hi - lo);
+    const double k1 = 1.0 / (std::sqrt(2.0 * M_PI) * s1);
+    const double k2 = 1.0 / (std::sqrt(2.0) * s2);
+
+    double sum = 0.0;
+    for (int i = 0; i < GaussLegendre::n; ++i)
+    {
+        const double u = mid + half * gl.x[i];
+        const double e = (u - u0) / s1;
+        const double chord = std::sqrt(std::max(radius * radius - u * u, 0.0));
+        const double inner = 0.5 * (std::erf((chord - w0) * k2) + std::erf((chord + w0) * k2));
+        sum += gl.w[i] * k1 * std::exp(-0.5 * e * e) * inner;
+    }
+    return std::clamp(sum * half, 0.0, 1.0);
+}
+
+double collision_probability_mc(const Vec2& own_pos,
+                                const Vec2& own_vel,
+                                const Vec2& tgt_pos,
+                                const Vec2& tgt_vel,
+                                const StateCov& cov,
+                                std::size_t samples,
+                                std::uint64_t seed,
+                                double radius,
+                                double horizon)
+{
+    if (samples == 0) return 0.0;
+
+    const CpaGaussian g = cpa_gaussian(own_pos, own_vel, tgt_pos, tgt_vel, cov, horizon);
+    const double t = g.t;
+
+    // Cholesky of the 4x4 covariance (lower L, L L^T = P)
+    const double P[4][4] = {
+        {cov.p00, cov.p01, cov.p02, cov.p03},
+        {cov.p01, cov.p11, cov.p12, cov.p13},
+        {cov.p02, cov.p12, cov.p22, cov.p23},
+        {cov.p03, cov.p13, cov.p23, cov.p33}
+    };
+    double L[4][4] = {};
+    for (int i = 0; i < 4; ++i)
+        for (int j = 0; j <= i; ++j)
+        {
+            double s = P[i][j];
+            for (int k = 0; k < j; ++k) s -= L[i][k] * L[j][k];
+            if (i == j)
+                L[i][i] = std::sqrt(std::max(s, 0.0));
+            else
+                L[i][j] = (L[j][j] > 0.0) ? s / L[j][j] : 0.0;
+        }
+
+    std::mt19937_64 rng(seed);
+    std::normal_distribution<double> normal;
+
+    const double ox = own_pos.x + own_vel.x * t, oy = own_pos.y + own_vel.y * t;
+    const double r2 = radius * radius;
+    std::size_t hits = 0;
+    for (std::size_t s = 0; s < samples; ++s)
+    {
+        double z[4];
+        for (double& zi : z) zi = normal(rng);
+
+        double st[4] = {tgt_pos.x, tgt_pos.y, tgt_vel.x, tgt_vel.y};
+        for (int i = 0; i < 4; ++i)
+            for (int k = 0; k <= i; ++k)
+                st[i] += L[i][k] * z[k];
+
+        const double dx = st[0] + st[2] * t - ox;
+        const double dy = st[1] + st[3] * t - oy;
+        if (dx * dx + dy * dy < r2) ++hits;
+    }
+    return static_cast<double>(hits) / static_cast<double>(samples);
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+#include "cpa.h"
+
+// Covariance of a target's [x, y, vx, vy] estimate, upper triangle
+// (same layout as KalmanBank).
+struct StateCov
+{
+    double p00{0.0}, p01{0.0}, p02{0.0}, p03{0.0};
+    double           p11{0.0}, p12{0.0}, p13{0.0};
+    double                     p22{0.0}, p23{0.0};
+    double                               p33{0.0};
+};
+
+// Probability that the target is inside the danger disc (radius around own
+// ship) at the CPA instant. The nominal TCPA is clamped to [0, horizon],
+// the target's position covariance is propagated to that instant along its
+// velocity covariance (own ship is taken as exact, no extra process noise)
+// and the resulting 2D Gaussian is integrated over the disc.
+//
+// Fast path: disc and Gaussian far apart (or the disc covering the whole
+// Gaussian) return 0 (or 1) at once; otherwise the integral is taken in
+// the covariance principal frame, exactly (erf) across the minor axis and
+// with 16-point Gauss-Legendre along the major axis.
+double collision_probability(const Vec2& own_pos,
+                             const Vec2& own_vel,
+                             const Vec2& tgt_pos,
+                             const Vec2& tgt_vel,
+                             const StateCov& cov,
+                             double radius = CPA_THRESHOLD_METERS,
+                             double horizon = TCPA_THRESHOLD_SECONDS);
+
+// Monte-Carlo reference for the same quantity: full 4D state samples are
+// drawn from N(state, cov), moved to the same instant and counted inside
+// the disc. For validating the fast path only.
+double collision_probability_mc(const Vec2& own_pos,
+                                const Vec2& own_vel,
+                                const Vec2& tgt_pos,
+                                const Vec2& tgt_vel,
+                                const StateCov& cov,
+                                std::size_t samples,
+                                std::uint64_t seed = 1,
+                                double radius = CPA_THRESHOLD_METERS,
+                                double horizon = TCPA_THRESHOLD_SECONDS);
@@ -0,0 +1,224 @@
+#include "encounter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace
+{
+
+struct Box
+{
+    double min_x, min_y, max_x, max_y;
+};
+
+struct CellEntry
+{
+    std::uint64_t key;
+    TrackId id;
+};
+
+// A box spanning more cells than this per axis, or lying beyond
+// MAX_CELL_INDEX, is screened against every target instead of gridded.
+constexpr double MAX_CELLS_PER_AXIS = 16.0;
+constexpr double MAX_CELL_INDEX = 1073741824.0;  // 2^30
+
+inline bool finite_target(const Vec2& p, const Vec2& v)
+{
+    return std::isfinite(p.x) && std::isfinite(p.y) && std::isfinite(v.x) && std::isfinite(v.y);
+}
+
+inline std::int64_t cell_of(double v, double inv_cell)
+{
+    return static_cast<std::int64_t>(std::floor(v * inv_cell));
+}
+
+inline std::uint64_t cell_key(std::int64_t cx, std::int64_t cy)
+{
+    return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(cx)) << 32)
+         | static_cast<std::uint32_t>(cy);
+}
+
+inline bool test_pair(const std::vector<Vec2>& pos, const std::vector<Vec2>& vel,
+                      TrackId a, TrackId b, std::vector<EncounterPair>& out)
+{
+    CpaResult r = compute_cpa(pos[a], vel[a], pos[b], vel[b]);
+    if (!r.collision_risk) return false;
+    out.push_back(EncounterPair{ a, b, r });
+    return true;
+}
+
+} // namespace
+
+void screen_encounters_brute(const std::vector<Vec2>& pos,
+                             const std::vector<Vec2>& vel,
+                             std::vector<EncounterPair>& out,
+                             EncounterStats* stats)
+{
+    out.clear();
+    const TrackId n = static_cast<TrackId>(pos.size());
+    std::size_t candidates = 0;
+    std::size_t skipped = 0;
+    for (TrackId a = 0; a < n; ++a)
+    {
+        if (!finite_target(pos[a], vel[a]))
+        {
+            ++skipped;
+            continue;
+        }
+        for (TrackId b = a + 1; b < n; ++b)
+        {
+            if (!finite_target(pos[b], vel[b])) continue;
+            ++candidates;
+            test_pair(pos, vel, a, b, out);
+        }
+    }
+
+    if (stats)
+    {
+        *stats = EncounterStats{};
+        stats->candidate_pairs = candidates;
+        stats->skipped = skipped;
+    }
+}
+
+void screen_encounters_grid(const std::vector<Vec2>& pos,
+                            const std::vector<Vec2>& vel,
+                            std::vector<EncounterPair>& out,
+                            EncounterStats* stats)
+{
+    out.clear();
+    const std::size_t n = pos.size();
+    if (n < 2)
+    {
+        if (stats) *stats = EncounterStats{};
+        return;
+    }
+
+    const double margin = 0.5 * CPA_THRESHOLD_METERS;
+
+    // swept box of every target over [0, TCPA_THRESHOLD_SECONDS]; targets
+    // with a NaN / inf position or velocity (or a box overflowing to inf)
+    // take no part
+    std::vector<Box> boxes(n);
+    std::vector<char> usable(n, 0);
+    std::vector<double> extent;
+    extent.reserve(n);
+    std::size_t skipped = 0;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        double ex = pos[i].x + vel[i].x * TCPA_THRESHOLD_SECONDS;
+        double ey = pos[i].y + vel[i].y * TCPA_THRESHOLD_SECONDS;
+        Box& b = boxes[i];
+        b.min_x = std::min(pos[i].x, ex) - margin;
+        b.max_x = std::max(pos[i].x, ex) + margin;
+        b.min_y = std::min(pos[i].y, ey) - margin;
+        b.max_y = std::max(pos[i].y, ey) + margin;
+        const double e = std::max(b.max_x - b.min_x, b.max_y - b.min_y);
+        if (!finite_target(pos[i], vel[i]) || !std::isfinite(e))
+        {
+            ++skipped;
+            continue;
+        }
+        usable[i] = 1;
+        extent.push_back(e);
+    }
+
+    std::size_t candidates = 0;
+    std::size_t cells = 0;
+    double cell = 0.0;
+    std::vector<TrackId> wide;
+
+    if (!extent.empty())
+    {
+        // pitch ~ the median box, so a typical target covers a few cells
+        const std::size_t mid = extent.size() / 2;
+        std::nth_element(extent.begin(), extent.begin() + mid, extent.end());
+        cell = std::max(extent[mid], CPA_THRESHOLD_METERS);
+    }
+    const double inv_cell = cell > 0.0 ? 1.0 / cell : 0.0;
+
+    // Outliers (a corrupt row, an absurd speed) would cover millions of
+    // cells; they go to a short list tested against everyone instead.
+    std::vector<CellEntry> entries;
+    entries.reserve(n * 4);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        if (!usable[i]) continue;
+        const Box& b = boxes[i];
+        const double fx0 = std::floor(b.min_x * inv_cell), fx1 = std::floor(b.max_x * inv_cell);
+        const double fy0 = std::floor(b.min_y * inv_cell), fy1 = std::floor(b.max_y * inv_cell);
+        if (fx1 - fx0 >= MAX_CELLS_PER_AXIS || fy1 - fy0 >= MAX_CELLS_PER_AXIS ||
+            std::max(std::fabs(fx0), std::fabs(fx1)) >= MAX_CELL_INDEX ||
+            std::max(std::fabs(fy0), std::fabs(fy1)) >= MAX_CELL_INDEX)
+        {
+            wide.push_back(static_cast<TrackId>(i));
+            usable[i] = 2;
+            continue;
+        }
+        const auto cx0 = static_cast<std::int64_t>(fx0), cx1 = static_cast<std::int64_t>(fx1);
+        const auto cy0 = static_cast<std::int64_t>(fy0), cy1 = static_cast<std::int64_t>(fy1);
+        for (std::int64_t cx = cx0; cx <= cx1; ++cx)
+            for (std::int64_t cy = cy0; cy <= cy1; ++cy)
+                entries.push_back(CellEntry{ cell_key(cx, cy), static_cast<TrackId>(i) });
+    }
+
+    std::sort(entries.begin(), entries.end(),
+              [](const CellEntry& l, const CellEntry& r)
+              { return l.key != r.key ? l.key < r.key : l.id < r.id; });
+
+    for (std::size_t begin = 0; begin < entries.size(); )
+    {
+        std::size_t end = begin + 1;
+        while (end < entries.size() && entries[end].key == entries[begin].key) ++end;
+        ++cells;
+
+        const std::uint64_t key = entries[begin].key;
+        for (std::size_t p = begin; p < end; ++p)
+        {
+            const TrackId a = entries[p].id;
+            const Box& ba = boxes[a];
+            for (std::size_t q = p + 1; q < end; ++q)
+            {
+                const TrackId b = entries[q].id;
+                const Box& bb = boxes[b];
+
+                // boxes must overlap, and the pair is handled only in the
+                // cell holding the low corner of the overlap
+                double ox = std::max(ba.min_x, bb.min_x);
+                double oy = std::max(ba.min_y, bb.min_y);
+                if (ox > std::min(ba.max_x, bb.max_x) || oy > std::min(ba.max_y, bb.max_y))
+                    continue;
+                if (cell_key(cell_of(ox, inv_cell), cell_of(oy, inv_cell)) != key)
+                    continue;
+
+                ++candidates;
+                test_pair(pos, vel, a, b, out);
+            }
+        }
+        begin = end;
+    }
+
+    // wide targets against all others, each pair once
+    for (TrackId w : wide)
+        for (std::size_t j = 0; j < n; ++j)
+        {
+            if (!usable[j] || j == w || (usable[j] == 2 && j < w)) continue;
+            ++candidates;
+            const TrackId o = static_cast<TrackId>(j);
+            test_pair(pos, vel, std::min(w, o), std::max(w, o), out);
+        }
+
+    std::sort(out.begin(), out.end(),
+              [](const EncounterPair& l, const EncounterPair& r)
+              { return l.a != r.a ? l.a < r.a : l.b < r.b; });
+
+    if (stats)
+    {
+        stats->candidate_pairs = candidates;
+        stats->cells = cells;
+        stats->cell_size = cell;
+        stats->wide = wide.size();
+        stats->skipped = skipped;
+    }
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+#include "cpa.h"
+#include "track_ids.h"
+
+// Target-to-target CPA screening.
+//
+// A pair is an encounter when compute_cpa between the two targets flags
+// collision_risk (CPA < CPA_THRESHOLD_METERS within TCPA_THRESHOLD_SECONDS).
+// Both screens report the same pairs, ordered by (a, b) with a < b.
+// Targets with a NaN or infinite position or velocity are left out.
+
+struct EncounterPair
+{
+    TrackId a;
+    TrackId b;
+    CpaResult cpa;   // b relative to a
+};
+
+struct EncounterStats
+{
+    std::size_t candidate_pairs{0};  // pairs passed to the exact CPA
+    std::size_t cells{0};            // occupied grid cells
+    double cell_size{0.0};           // grid pitch [m]
+    std::size_t wide{0};             // boxes too large for the grid, checked against all
+    std::size_t skipped{0};          // NaN / inf position or velocity, not screened
+};
+
+// Exact CPA on all N*(N-1)/2 pairs.
+void screen_encounters_brute(const std::vector<Vec2>& pos,
+                             const std::vector<Vec2>& vel,
+                             std::vector<EncounterPair>& out,
+                             EncounterStats* stats = nullptr);
+
+// Uniform grid over the segments each target sweeps during the TCPA
+// horizon, widened by half the CPA threshold. Two targets can only meet
+// within the threshold if their widened boxes overlap, so exact CPA runs
+// only on pairs sharing a cell. A box spanning more than 16 cells per axis
+// (an outlier speed or position) is not gridded but checked against every
+// target, so one bad row costs O(N) instead of flooding the grid.
+void screen_encounters_grid(const std::vector<Vec2>& pos,
+                            const std::vector<Vec2>& vel,
+                            std::vector<EncounterPair>& out,
+                            EncounterStats* stats = nullptr);
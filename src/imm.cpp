@@ -0,0 +1,231 @@
+#include "imm.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "simd.h"
+
+namespace
+{
+
+constexpr int M = ImmBank::M;
+
+// per-track columns of a bank: x y vx vy, then the covariance upper triangle
+constexpr int C = 14;
+constexpr int row_of[10] = {0, 0, 0, 0, 1, 1, 1, 2, 2, 3};
+constexpr int col_of[10] = {0, 1, 2, 3, 1, 2, 3, 2, 3, 3};
+
+void bank_columns(KalmanBank& b, double* out[C])
+{
+    std::vector<double>* v[C] = {&b.x, &b.y, &b.vx, &b.vy,
+                                 &b.p00, &b.p01, &b.p02, &b.p03, &b.p11,
+                                 &b.p12, &b.p13, &b.p22, &b.p23, &b.p33};
+    for (int k = 0; k < C; ++k) out[k] = v[k]->data();
+}
+
+struct Columns
+{
+    double* model[M][C];
+    double* est[C];
+    double* mu[M];
+    double* cbar[M];
+    double pi[M][M];  // pi[i][j]: probability of switching from model i to j
+};
+
+template <class S>
+inline typename S::M active_mask(const std::uint8_t* active, std::size_t i)
+{
+    return active ? S::load_mask(active + i) : S::ge(S::set1(0.0), S::set1(0.0));
+}
+
+// Gaussian mixture of the M model estimates with weights w into out
+// (state and covariance including the spread of the means).
+template <class S>
+inline void moment_match(const typename S::V (&src)[M][C],
+                         const typename S::V (&w)[M],
+                         typename S::V (&out)[C])
+{
+    using V = typename S::V;
+
+    for (int s = 0; s < 4; ++s)
+    {
+        V acc = w[0] * src[0][s];
+        for (int k = 1; k < M; ++k) acc = acc + w[k] * src[k][s];
+        out[s] = acc;
+    }
+
+    V d[M][4];
+    for (int k = 0; k < M; ++k)
+        for (int s = 0; s < 4; ++s)
+            d[k][s] = src[k][s] - out[s];
+
+    for (int e = 0; e < 10; ++e)
+    {
+        const int a = row_of[e], b = col_of[e];
+        V acc = w[0] * (src[0][4 + e] + d[0][a] * d[0][b]);
+        for (int k = 1; k < M; ++k)
+            acc = acc + w[k] * (src[k][4 + e] + d[k][a] * d[k][b]);
+        out[4 + e] = acc;
+    }
+}
+
+// Interaction step: each model restarts from the mixture of all models
+// weighted by the probability of having switched into it.
+template <class S>
+inline void mix_lanes(const Columns& c, std::size_t i, const std::uint8_t* active)
+{
+    using V = typename S::V;
+    const typename S::M on = active_mask<S>(active, i);
+
+    V mu[M];
+    V src[M][C];
+    for (int k = 0; k < M; ++k)
+    {
+        mu[k] = S::load(c.mu[k] + i);
+        for (int col = 0; col < C; ++col)
+            src[k][col] = S::load(c.model[k][col] + i);
+    }
+
+    for (int j = 0; j < M; ++j)
+    {
+        V cbar = S::set1(c.pi[0][j]) * mu[0];
+        for (int k = 1; k < M; ++k) cbar = cbar + S::set1(c.pi[k][j]) * mu[k];
+        S::store(c.cbar[j] + i, cbar);
+
+        const V inv = S::set1(1.0) / cbar;
+        V w[M];
+        for (int k = 0; k < M; ++k) w[k] = S::set1(c.pi[k][j]) * mu[k] * inv;
+
+        V mixed[C];
+        moment_match<S>(src, w, mixed);
+        for (int col = 0; col < C; ++col)
+            S::store(c.model[j][col] + i, S::select(on, mixed[col], src[j][col]));
+    }
+}
+
+template <class S>
+inline void combine_lanes(const Columns& c, std::size_t i, const std::uint8_t* active)
+{
+    using V = typename S::V;
+    const typename S::M on = active_mask<S>(active, i);
+
+    V w[M];
+    V src[M][C];
+    for (int k = 0; k < M; ++k)
+    {
+        w[k] = S::load(c.mu[k] + i);
+        for (int col = 0; col < C; ++col)
+            src[k][col] = S::load(c.model[k][col] + i);
+    }
+
+    V out[C];
+    moment_match<S>(src, w, out);
+    for (int col = 0; col < C; ++col)
+        S::store(c.est[col] + i, S::select(on, out[col], S::load(c.est[col] + i)));
+}
+
+template <void (*Lanes_wide)(const Columns&, std::size_t, const std::uint8_t*),
+          void (*Lanes_scalar)(const Columns&, std::size_t, const std::uint8_t*)>
+void run_lanes(const Columns& c, std::size_t n, const std::uint8_t* active)
+{
+    std::size_t i = 0;
+    for (; i + simd::Wide::width <= n; i += simd::Wide::width)
+        Lanes_wide(c, i, active);
+    for (; i < n; ++i)
+        Lanes_scalar(c, i, active);
+}
+
+} // namespace
+
+void ImmBank::resize(std::size_t count)
+{
+    n = count;
+    for (int k = 0; k < M; ++k)
+    {
+        model[k].resize(count);
+        mu[k].assign(count, 1.0 / M);
+        cbar_[k].assign(count, 1.0 / M);
+        nis_[k].assign(count, 0.0);
+        det_[k].assign(count, 1.0);
+    }
+    est.resize(count);
+    for (auto* v : {&ta_, &tb_, &tc_, &ts_, &nb_, &ns_})
+        v->assign(count, 0.0);
+}
+
+void ImmBank::init(std::size_t i, double x0, double y0, double vx0, double vy0)
+{
+    for (int k = 0; k < M; ++k)
+    {
+        model[k].init(i, x0, y0, vx0, vy0);
+        mu[k][i] = 1.0 / M;
+    }
+    est.init(i, x0, y0, vx0, vy0);
+}
+
+void ImmBank::step(const double* dt, const double* zx, const double* zy,
+                   const std::uint8_t* active)
+{
+    Columns c;
+    for (int k = 0; k < M; ++k)
+    {
+        bank_columns(model[k], c.model[k]);
+        c.mu[k] = mu[k].data();
+        c.cbar[k] = cbar_[k].data();
+        for (int j = 0; j < M; ++j)
+            c.pi[k][j] = (k == j) ? cfg.p_stay : (1.0 - cfg.p_stay) / (M - 1);
+    }
+    bank_columns(est, c.est);
+
+    run_lanes<mix_lanes<simd::Wide>, mix_lanes<simd::Scalar>>(c, n, active);
+
+    // turn coefficients; samples usually share dt, so reuse the last one
+    const double w = cfg.turn_rate;
+    double last_dt = -1.0, a = 0.0, b = 0.0, cs = 1.0, sn = 0.0;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        if (dt[i] != last_dt)
+        {
+            last_dt = dt[i];
+            sn = std::sin(w * last_dt);
+            cs = std::cos(w * last_dt);
+            a = sn / w;
+            b = (1.0 - cs) / w;
+        }
+        ta_[i] = a; tb_[i] = b; tc_[i] = cs; ts_[i] = sn;
+        nb_[i] = -b; ns_[i] = -sn;
+    }
+
+    model[0].predict(dt, active);
+    model[1].predict_turn(ta_.data(), tb_.data(), tc_.data(), ts_.data(), active);
+    model[2].predict_turn(ta_.data(), nb_.data(), tc_.data(), ns_.data(), active);
+
+    for (int k = 0; k < M; ++k)
+        model[k].update(zx, zy, active, nis_[k].data(), det_[k].data());
+
+    // mu_j ~ cbar_j * N(innovation; 0, S_j); the smallest NIS is factored
+    // out so that at least one likelihood stays representable
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        if (active && !active[i]) continue;
+
+        double nis_min = nis_[0][i];
+        for (int k = 1; k < M; ++k) nis_min = std::min(nis_min, nis_[k][i]);
+
+        double l[M], sum = 0.0;
+        for (int k = 0; k < M; ++k)
+        {
+            l[k] = cbar_[k][i] * std::exp(-0.5 * (nis_[k][i] - nis_min))
+                 / std::sqrt(det_[k][i]);
+            sum += l[k];
+        }
+        if (!(sum > 0.0) || !std::isfinite(sum))
+        {
+            for (int k = 0; k < M; ++k) mu[k][i] = cbar_[k][i];
+            continue;
+        }
+        for (int k = 0; k < M; ++k) mu[k][i] = l[k] / sum;
+    }
+
+    run_lanes<combine_lanes<simd::Wide>, combine_lanes<simd::Scalar>>(c, n, active);
+}
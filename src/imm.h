@@ -0,0 +1,49 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "kalman_bank.h"
+
+struct ImmConfig
+{
+    double turn_rate{0.05};  // rad/s of the two coordinated-turn models (~3 deg/s)
+    double p_stay{0.95};     // probability of keeping the same model between samples
+};
+
+// Interacting Multiple Model filter for N tracks.
+//
+// Three models per track: constant velocity and coordinated turns to port
+// (+turn_rate) and starboard (-turn_rate). Each model lives in its own
+// KalmanBank, and mixing, model-probability update and the combined
+// estimate are computed across tracks the same way, so one step costs a
+// few bank steps rather than three filters per track.
+struct ImmBank
+{
+    static constexpr int M = 3;
+
+    std::size_t n{0};
+    ImmConfig cfg;
+
+    KalmanBank model[M];         // CV, turn to port, turn to starboard
+    std::vector<double> mu[M];   // model probabilities
+    KalmanBank est;              // mixed state and covariance
+
+    void resize(std::size_t count);
+
+    // All models start from the KalmanFilter2D initial state and
+    // covariance with equal probability.
+    void init(std::size_t i, double x0, double y0, double vx0, double vy0);
+
+    // Mix, predict over dt, update with the measurement, then refresh the
+    // model probabilities and `est`. Tracks whose `active` byte is 0 are
+    // left untouched; pass nullptr to step every track.
+    void step(const double* dt, const double* zx, const double* zy,
+              const std::uint8_t* active = nullptr);
+
+private:
+    std::vector<double> cbar_[M];            // predicted model probabilities
+    std::vector<double> nis_[M], det_[M];    // innovation statistics
+    std::vector<double> ta_, tb_, tc_, ts_;  // turn coefficients (port)
+    std::vector<double> nb_, ns_;            // negated b and s (starboard)
+};
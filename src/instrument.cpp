@@ -0,0 +1,224 @@
+#include "instrument.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace instr
+{
+
+const char* stage_name(Stage s)
+{
+    switch (s)
+    {
+    case Stage::Load:         return "load";
+    case Stage::Associate:    return "associate";
+    case Stage::Filter:       return "filter";
+    case Stage::FilterTrack:  return "filter/track";
+    case Stage::Cpa:          return "cpa";
+    case Stage::Probability:  return "probability";
+    case Stage::Pairs:        return "pairs";
+    case Stage::Table:        return "table";
+    case Stage::Radar:        return "radar";
+    case Stage::Json:         return "json";
+    case Stage::Ndjson:       return "ndjson";
+    case Stage::Scan:         return "scan";
+    case Stage::StreamUpdate: return "stream/update";
+    case Stage::SmoothTrack:  return "smooth/track";
+    case Stage::Count:        break;
+    }
+    return "?";
+}
+
+#if CPA_INSTRUMENT
+
+namespace
+{
+
+constexpr int SUB_BITS = 5;
+constexpr std::uint64_t SUB = 1u << SUB_BITS;   // 32
+constexpr int MAX_EXP = 40;                     // ~18 min, larger values clamp
+constexpr std::size_t BUCKETS = SUB + (MAX_EXP - SUB_BITS + 1) * SUB;
+constexpr std::size_t STAGES = static_cast<std::size_t>(Stage::Count);
+
+int floor_log2(std::uint64_t v)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return 63 - __builtin_clzll(v);
+#else
+    int e = 0;
+    while (v >>= 1) ++e;
+    return e;
+#endif
+}
+
+std::size_t bucket_of(std::uint64_t v)
+{
+    if (v < SUB) return static_cast<std::size_t>(v);
+    int e = floor_log2(v);
+    if (e > MAX_EXP)
+    {
+        e = MAX_EXP;
+        v = (std::uint64_t{1} << (MAX_EXP + 1)) - 1;
+    }
+    std::uint64_t sub = (v >> (e - SUB_BITS)) - SUB;
+    return SUB + static_cast<std::size_t>(e - SUB_BITS) * SUB + static_cast<std::size_t>(sub);
+}
+
+// largest value that lands in bucket b
+std::uint64_t bucket_high(std::size_t b)
+{
+    if (b < SUB) return b;
+    std::size_t e = (b - SUB) / SUB + SUB_BITS;
+    std::uint64_t sub = (b - SUB) % SUB + SUB;
+    return ((sub + 1) << (e - SUB_BITS)) - 1;
+}
+
+// Written only by its owning thread; relaxed load + store, no RMW.
+struct Cell
+{
+    std::atomic<std::uint64_t> v{0};
+
+    void add(std::uint64_t d) { v.store(v.load(std::memory_order_relaxed) + d, std::memory_order_relaxed); }
+    void max(std::uint64_t d)
+    {
+        if (d > v.load(std::memory_order_relaxed)) v.store(d, std::memory_order_relaxed);
+    }
+    std::uint64_t get() const { return v.load(std::memory_order_relaxed); }
+};
+
+struct StageBlock
+{
+    Cell calls, items, total_ns, max_ns;
+    Cell hist[BUCKETS];
+};
+
+struct ThreadBlock
+{
+    StageBlock stages[STAGES];
+};
+
+std::atomic<bool> g_enabled{false};
+std::mutex g_registry_mutex;
+std::vector<std::unique_ptr<ThreadBlock>> g_registry;
+
+ThreadBlock& thread_block()
+{
+    thread_local ThreadBlock* block = nullptr;
+    if (!block)
+    {
+        auto owned = std::make_unique<ThreadBlock>();
+        block = owned.get();
+        std::lock_guard<std::mutex> lock(g_registry_mutex);
+        g_registry.push_back(std::move(owned));
+    }
+    return *block;
+}
+
+void format_ns(char* buf, std::size_t size, double ns)
+{
+    if (ns < 1e3)      std::snprintf(buf, size, "%.0f ns", ns);
+    else if (ns < 1e6) std::snprintf(buf, size, "%.1f us", ns / 1e3);
+    else if (ns < 1e9) std::snprintf(buf, size, "%.1f ms", ns / 1e6);
+    else               std::snprintf(buf, size, "%.2f s", ns / 1e9);
+}
+
+} // namespace
+
+bool enabled()
+{
+    return g_enabled.load(std::memory_order_relaxed);
+}
+
+void set_enabled(bool on)
+{
+    g_enabled.store(on, std::memory_order_relaxed);
+}
+
+void record(Stage s, std::uint64_t ns, std::uint64_t items)
+{
+    StageBlock& b = thread_block().stages[static_cast<std::size_t>(s)];
+    b.calls.add(1);
+    b.items.add(items);
+    b.total_ns.add(ns);
+    b.max_ns.max(ns);
+    b.hist[bucket_of(ns)].add(1);
+}
+
+bool summarize(Stage s, StageSummary& out)
+{
+    thread_local std::vector<std::uint64_t> hist;
+    hist.assign(BUCKETS, 0);
+
+    out = StageSummary{};
+    {
+        std::lock_guard<std::mutex> lock(g_registry_mutex);
+        for (const auto& tb : g_registry)
+        {
+            const StageBlock& b = tb->stages[static_cast<std::size_t>(s)];
+            out.calls    += b.calls.get();
+            out.items    += b.items.get();
+            out.total_ns += b.total_ns.get();
+            out.max_ns    = std::max(out.max_ns, b.max_ns.get());
+            for (std::size_t k = 0; k < BUCKETS; ++k) hist[k] += b.hist[k].get();
+        }
+    }
+    if (out.calls == 0) return false;
+
+    // highest value of the bucket holding the given rank, capped by max
+    auto quantile = [&](double q)
+    {
+        std::uint64_t rank = static_cast<std::uint64_t>(q * static_cast<double>(out.calls) + 0.5);
+        rank = std::max<std::uint64_t>(rank, 1);
+        std::uint64_t seen = 0;
+        for (std::size_t k = 0; k < BUCKETS; ++k)
+        {
+            seen += hist[k];
+            if (seen >= rank) return std::min(bucket_high(k), out.max_ns);
+        }
+        return out.max_ns;
+    };
+    out.p50_ns = quantile(0.50);
+    out.p99_ns = quantile(0.99);
+    return true;
+}
+
+void report(std::ostream& os)
+{
+    std::string out = "=== Stage latency ===\n";
+    char line[256];
+    std::snprintf(line, sizeof(line), "%-14s %9s %11s %10s %10s %10s %10s %13s\n",
+                  "Stage", "Calls", "Items", "p50", "p99", "max", "total", "Items/s");
+    out += line;
+    out += std::string(14 + 9 + 11 + 10 * 4 + 13 + 7, '-');
+    out += '\n';
+
+    for (std::size_t s = 0; s < STAGES; ++s)
+    {
+        StageSummary sum;
+        if (!summarize(static_cast<Stage>(s), sum)) continue;
+
+        char p50[24], p99[24], pmax[24], ptot[24];
+        format_ns(p50, sizeof(p50), static_cast<double>(sum.p50_ns));
+        format_ns(p99, sizeof(p99), static_cast<double>(sum.p99_ns));
+        format_ns(pmax, sizeof(pmax), static_cast<double>(sum.max_ns));
+        format_ns(ptot, sizeof(ptot), static_cast<double>(sum.total_ns));
+        double rate = sum.total_ns ? static_cast<double>(sum.items) * 1e9 / static_cast<double>(sum.total_ns) : 0.0;
+
+        std::snprintf(line, sizeof(line), "%-14s %9llu %11llu %10s %10s %10s %10s %13.0f\n",
+                      stage_name(static_cast<Stage>(s)),
+                      static_cast<unsigned long long>(sum.calls),
+                      static_cast<unsigned long long>(sum.items),
+                      p50, p99, pmax, ptot, rate);
+        out += line;
+    }
+    os.write(out.data(), static_cast<std::streamsize>(out.size()));
+}
+
+#endif
+
+} // namespace instr
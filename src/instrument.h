@@ -0,0 +1,126 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+// Hot-path instrumentation: scoped timers feeding per-stage latency
+// histograms, and per-stage item counters for throughput.
+//
+// Every thread records into its own block (registered once under a mutex),
+// so recording is a handful of relaxed atomic stores with no contention.
+// Histograms are HDR-style: values in nanoseconds, exact below 32 ns and
+// then 32 linear sub-buckets per power of two (about 3 % resolution).
+// Recording is off until set_enabled(true); while off a timer costs one
+// relaxed load. Built with CPA_INSTRUMENT=0 the macros expand to nothing.
+
+#ifndef CPA_INSTRUMENT
+#define CPA_INSTRUMENT 1
+#endif
+
+namespace instr
+{
+
+enum class Stage : std::uint8_t
+{
+    Load,
+    Associate,
+    Filter,         // all tracks (items = tracks)
+    FilterTrack,    // one track (items = rows)
+    Cpa,
+    Probability,
+    Pairs,
+    Table,
+    Radar,
+    Json,
+    Ndjson,
+    Scan,           // one scan (items = measurements)
+    StreamUpdate,   // one streamed row
+    SmoothTrack,    // RTS smoothing of one track (items = rows)
+    Count
+};
+
+const char* stage_name(Stage s);
+
+// One stage merged over all threads.
+struct StageSummary
+{
+    std::uint64_t calls{0};
+    std::uint64_t items{0};
+    std::uint64_t total_ns{0};
+    std::uint64_t max_ns{0};
+    std::uint64_t p50_ns{0};
+    std::uint64_t p99_ns{0};
+};
+
+#if CPA_INSTRUMENT
+
+bool enabled();
+void set_enabled(bool on);
+
+// Add one sample of `ns` nanoseconds covering `items` items.
+void record(Stage s, std::uint64_t ns, std::uint64_t items);
+
+class ScopedTimer
+{
+public:
+    explicit ScopedTimer(Stage s, std::uint64_t items = 1)
+        : stage_(s), items_(items), on_(enabled())
+    {
+        if (on_) t0_ = std::chrono::steady_clock::now();
+    }
+
+    ~ScopedTimer()
+    {
+        if (!on_) return;
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - t0_).count();
+        record(stage_, static_cast<std::uint64_t>(ns), items_);
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    // Item count known only at the end of the scope.
+    void set_items(std::uint64_t items) { items_ = items; }
+
+private:
+    Stage stage_;
+    std::uint64_t items_;
+    bool on_;
+    std::chrono::steady_clock::time_point t0_;
+};
+
+// False if the stage has not recorded anything. Safe to call from any
+// thread while others record; the counts are read without stopping them.
+bool summarize(Stage s, StageSummary& out);
+
+// Calls, items, p50 / p99 / max latency and throughput of every stage
+// that recorded something, merged over all threads.
+void report(std::ostream& os);
+
+#define CPA_INSTR_CAT2(a, b) a##b
+#define CPA_INSTR_CAT(a, b) CPA_INSTR_CAT2(a, b)
+#define CPA_TIMED_SCOPE(stage) \
+    ::instr::ScopedTimer CPA_INSTR_CAT(cpa_timer_, __LINE__)(::instr::Stage::stage)
+#define CPA_TIMED_SCOPE_N(stage, items) \
+    ::instr::ScopedTimer CPA_INSTR_CAT(cpa_timer_, __LINE__)(::instr::Stage::stage, (items))
+// Named timer whose item count is set later with CPA_SET_ITEMS.
+#define CPA_TIMER(name, stage) ::instr::ScopedTimer name(::instr::Stage::stage)
+#define CPA_SET_ITEMS(name, items) name.set_items(items)
+
+#else
+
+inline bool enabled() { return false; }
+inline void set_enabled(bool) {}
+inline bool summarize(Stage, StageSummary&) { return false; }
+inline void report(std::ostream&) {}
+
+#define CPA_TIMED_SCOPE(stage) ((void)0)
+#define CPA_TIMED_SCOPE_N(stage, items) ((void)(items))
+#define CPA_TIMER(name, stage) ((void)0)
+#define CPA_SET_ITEMS(name, items) ((void)(items))
+
+#endif
+
+} // namespace instr
@@ -1,9 +1,13 @@
 #include "io.h"
-#include <fstream>
-#include <sstream>
+#include "mapped_file.h"
+#include "thread_pool.h"
 #include <iostream>
+#include <sstream>
 #include <algorithm>
 #include <cctype>
+#include <cmath>
+#include <charconv>
+#include <iterator>
 
 static inline void trim_inplace(std::string& s)
 {
@@ -19,70 +23,337 @@ std::string trim_copy(const std::string& s)
     return t;
 }
 
-bool load_timeseries_from_csv(const std::string& path,
-                              std::map<std::string, std::vector<Measurement>>& out)
+static inline std::string_view trim_view(std::string_view s)
+{
+    auto isspace2 = [](char c){ return std::isspace(static_cast<unsigned char>(c)) != 0; };
+    while (!s.empty() && isspace2(s.front())) s.remove_prefix(1);
+    while (!s.empty() && isspace2(s.back()))  s.remove_suffix(1);
+    return s;
+}
+
+// The whole field must be a finite number (std::from_chars, locale
+// independent); "nan" and "inf" are rejected like any other bad field.
+static inline bool parse_double(std::string_view s, double& out)
+{
+    if (!s.empty() && s.front() == '+') s.remove_prefix(1);
+    const char* end = s.data() + s.size();
+    auto res = std::from_chars(s.data(), end, out);
+    return res.ec == std::errc() && res.ptr == end && std::isfinite(out);
+}
+
+bool parse_measurement_row(std::string_view line, MeasurementView& row, std::ostream& err)
 {
-    std::ifstream file(path);
-    if (!file)
+    std::string_view fields[6];
+    std::size_t count = 0;
+
+    // a comma ending the line opens no field (as getline splitting did),
+    // so "0,1,100,50,5,180," still has six
+    std::string_view body = line;
+    if (!body.empty() && body.back() == ',') body.remove_suffix(1);
+
+    std::size_t start = 0;
+    for (;;)
     {
-        std::cerr << "Failed to open file: " << path << "\n";
-        return false;
+        std::size_t comma = body.find(',', start);
+        std::string_view f = body.substr(start, comma == std::string_view::npos
+                                                    ? std::string_view::npos
+                                                    : comma - start);
+        if (count < 6) fields[count] = trim_view(f);
+        ++count;
+        if (comma == std::string_view::npos) break;
+        start = comma + 1;
     }
 
-    std::string line;
-    if (!std::getline(file, line))
+    if (count != 6)
     {
-        std::cerr << "Empty file or read error: " << path << "\n";
+        err << "Invalid CSV line (expected 6 columns): " << line << "\n";
         return false;
     }
 
-    // we are waiting for the title: time,id,x,y,speed,course
+    static const char* const names[6] = { "time", "id", "x", "y", "speed", "course" };
+    double* targets[6] = { &row.time, nullptr, &row.x, &row.y, &row.speed, &row.course_deg };
+    for (int k = 0; k < 6; ++k)
+    {
+        if (!targets[k]) continue;
+        if (!parse_double(fields[k], *targets[k]))
+        {
+            err << "Parse error: invalid " << names[k] << " '" << fields[k]
+                      << "' in line: " << line << "\n";
+            return false;
+        }
+    }
+    row.id = fields[1];
+
+    return true;
+}
+
+bool parse_measurement_line(const std::string& line, TrackIdTable& ids, Measurement& m)
+{
+    MeasurementView row;
+    if (!parse_measurement_row(line, row, std::cerr)) return false;
+
+    m.time       = row.time;
+    m.id         = ids.intern(row.id);
+    m.x          = row.x;
+    m.y          = row.y;
+    m.speed      = row.speed;
+    m.course_deg = row.course_deg;
+    return true;
+}
+
+std::size_t TrackSeries::num_rows() const
+{
+    std::size_t rows = 0;
+    for (const auto& seq : series) rows += seq.size();
+    return rows;
+}
+
+std::vector<Measurement>& TrackSeries::track(std::string_view name)
+{
+    TrackId id = ids.intern(name);
+    if (id >= series.size()) series.resize(id + 1);
+    return series[id];
+}
+
+void TrackSeries::sort_by_name()
+{
+    std::vector<TrackId> remap;
+    ids.sort_by_name(remap);
+
+    std::vector<std::vector<Measurement>> sorted(series.size());
+    for (std::size_t k = 0; k < series.size(); ++k)
+    {
+        TrackId id = remap[k];
+        for (auto& m : series[k]) m.id = id;
+        sorted[id] = std::move(series[k]);
+    }
+    series.swap(sorted);
+}
 
-    while (std::getline(file, line))
+namespace
+{
+
+// Parse one slice of the file into slice-local track ids.
+void parse_chunk(std::string_view text, TrackSeries& out, std::ostream& err)
+{
+    std::size_t pos = 0;
+    while (pos < text.size())
     {
+        std::size_t eol = text.find('\n', pos);
+        if (eol == std::string_view::npos) eol = text.size();
+
+        std::string_view line = text.substr(pos, eol - pos);
+        pos = eol + 1;
+
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
         if (line.empty()) continue;
 
-        std::stringstream ss(line);
-        std::string field;
-        std::vector<std::string> fields;
-        while (std::getline(ss, field, ','))
+        MeasurementView row;
+        if (!parse_measurement_row(line, row, err)) continue;
+
+        TrackId id = out.ids.intern(row.id);
+        if (id == out.series.size()) out.series.emplace_back();
+
+        out.series[id].push_back(Measurement{
+            row.time, id, row.x, row.y, row.speed, row.course_deg });
+    }
+}
+
+bool time_less(const Measurement& a, const Measurement& b)
+{
+    return a.time < b.time;
+}
+
+// Append the pieces of one track (given in file order) to dest, ordered by
+// time, and stamp them with `id`. Ties keep file order, so the result
+// equals a stable sort of the concatenation. Already ordered data is only
+// copied; pieces that are ordered on their own are k-way merged instead of
+// re-sorted.
+void merge_parts(std::vector<std::vector<Measurement>*>& parts,
+                 TrackId id,
+                 std::vector<Measurement>& dest)
+{
+    for (auto* p : parts)
+        for (auto& m : *p) m.id = id;
+
+    std::vector<Measurement> prev;
+    if (!dest.empty())
+    {
+        prev.swap(dest);
+        parts.insert(parts.begin(), &prev);
+    }
+
+    std::size_t total = 0;
+    bool concat_sorted = true;
+    const Measurement* last = nullptr;
+    for (auto* p : parts)
+    {
+        total += p->size();
+        if (!std::is_sorted(p->begin(), p->end(), time_less))
         {
-            trim_inplace(field);
-            fields.push_back(field);
+            std::stable_sort(p->begin(), p->end(), time_less);
+            concat_sorted = false;
         }
-
-        if (fields.size() != 6)
+        if (!p->empty())
         {
-            std::cerr << "Invalid CSV line (expected 6 columns): " << line << "\n";
-            continue;
+            if (last && p->front().time < last->time) concat_sorted = false;
+            last = &p->back();
         }
+    }
+
+    if (parts.size() == 1)
+    {
+        dest = std::move(*parts.front());
+        return;
+    }
+
+    dest.reserve(total);
+
+    if (concat_sorted)
+    {
+        for (auto* p : parts)
+            std::move(p->begin(), p->end(), std::back_inserter(dest));
+        return;
+    }
+
+    struct Head
+    {
+        double time;
+        std::size_t part;
+        std::size_t idx;
+    };
+    auto later = [](const Head& a, const Head& b)
+    {
+        return a.time != b.time ? a.time > b.time : a.part > b.part;
+    };
+
+    std::vector<Head> heap;
+    heap.reserve(parts.size());
+    for (std::size_t k = 0; k < parts.size(); ++k)
+        if (!parts[k]->empty()) heap.push_back(Head{ (*parts[k])[0].time, k, 0 });
+    std::make_heap(heap.begin(), heap.end(), later);
 
-        Measurement m;
-        try
+    while (!heap.empty())
+    {
+        std::pop_heap(heap.begin(), heap.end(), later);
+        Head& h = heap.back();
+        auto& src = *parts[h.part];
+        dest.push_back(std::move(src[h.idx]));
+        if (++h.idx < src.size())
         {
-            m.time       = std::stod(fields[0]);
-            m.id         = fields[1];
-            m.x          = std::stod(fields[2]);
-            m.y          = std::stod(fields[3]);
-            m.speed      = std::stod(fields[4]);
-            m.course_deg = std::stod(fields[5]);
+            h.time = src[h.idx].time;
+            std::push_heap(heap.begin(), heap.end(), later);
         }
-        catch (const std::exception& e)
+        else
         {
-            std::cerr << "Parse error: " << e.what() << " in line: " << line << "\n";
-            continue;
+            heap.pop_back();
         }
+    }
+}
 
-        out[m.id].push_back(m);
+// Mapped file with the header line skipped; false on open error or empty file.
+bool open_csv_body(const std::string& path, MappedFile& file, std::string_view& body)
+{
+    if (!file.open(path))
+    {
+        std::cerr << "Failed to open file: " << path << "\n";
+        return false;
     }
 
-    // sort by time within each id
-    for (auto& kv : out)
+    std::string_view text = file.view();
+    if (text.empty())
     {
-        auto& vec = kv.second;
-        std::sort(vec.begin(), vec.end(),
-                  [](const Measurement& a, const Measurement& b){ return a.time < b.time; });
+        std::cerr << "Empty file or read error: " << path << "\n";
+        return false;
     }
 
+    // we are waiting for the title: time,id,x,y,speed,course
+    std::size_t pos = text.find('\n');
+    pos = (pos == std::string_view::npos) ? text.size() : pos + 1;
+    body = text.substr(pos);
+    return true;
+}
+
+} // namespace
+
+bool load_timeseries_from_csv(const std::string& path, TrackSeries& out)
+{
+    MappedFile file;
+    std::string_view body;
+    if (!open_csv_body(path, file, body)) return false;
+
+    TrackSeries chunk;
+    parse_chunk(body, chunk, std::cerr);
+
+    std::vector<std::vector<Measurement>*> parts;
+    for (TrackId k = 0; k < chunk.size(); ++k)
+    {
+        TrackId id = out.ids.intern(chunk.ids.name(k));
+        if (id >= out.series.size()) out.series.resize(id + 1);
+        parts.assign(1, &chunk.series[k]);
+        merge_parts(parts, id, out.series[id]);
+    }
+
+    out.sort_by_name();
+    return true;
+}
+
+bool load_timeseries_from_csv_parallel(const std::string& path,
+                                       TrackSeries& out,
+                                       ThreadPool& pool)
+{
+    MappedFile file;
+    std::string_view body;
+    if (!open_csv_body(path, file, body)) return false;
+
+    // a few slices per thread, cut right after a newline
+    const std::size_t target = std::max<std::size_t>(1, std::size_t{pool.size()} * 4);
+    const std::size_t min_slice = 1 << 20;
+    const std::size_t num_slices = std::max<std::size_t>(1, std::min(target, body.size() / min_slice));
+
+    std::vector<std::string_view> slices;
+    std::size_t begin = 0;
+    for (std::size_t k = 1; k <= num_slices && begin < body.size(); ++k)
+    {
+        std::size_t end = body.size();
+        if (k < num_slices)
+        {
+            end = body.find('\n', std::max(begin, body.size() * k / num_slices));
+            end = (end == std::string_view::npos) ? body.size() : end + 1;
+        }
+        slices.push_back(body.substr(begin, end - begin));
+        begin = end;
+    }
+
+    std::vector<TrackSeries> chunks(slices.size());
+    std::vector<std::ostringstream> errors(slices.size());
+    pool.parallel_for(slices.size(), [&](std::size_t k)
+    {
+        parse_chunk(slices[k], chunks[k], errors[k]);
+    });
+
+    // report malformed rows in file order
+    for (const auto& e : errors) std::cerr << e.str();
+
+    // group the pieces of each track in slice (= file) order
+    std::vector<std::vector<std::vector<Measurement>*>> pieces;
+    for (auto& c : chunks)
+    {
+        for (TrackId k = 0; k < c.size(); ++k)
+        {
+            TrackId id = out.ids.intern(c.ids.name(k));
+            if (id >= pieces.size()) pieces.resize(id + 1);
+            pieces[id].push_back(&c.series[k]);
+        }
+    }
+    if (out.series.size() < pieces.size()) out.series.resize(pieces.size());
+
+    pool.parallel_for(pieces.size(), [&](std::size_t id)
+    {
+        if (!pieces[id].empty())
+            merge_parts(pieces[id], static_cast<TrackId>(id), out.series[id]);
+    });
+
+    out.sort_by_name();
     return true;
 }
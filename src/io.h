@@ -1,22 +1,74 @@
 #pragma once
+#include <iostream>
 #include <string>
+#include <string_view>
 #include <vector>
-#include <map>
+
+#include "track_ids.h"
 
 struct Measurement
 {
     double time;        // seconds
-    std::string id;
+    TrackId id;         // index into the loader's TrackIdTable
     double x;
     double y;
     double speed;
     double course_deg;
 };
 
+// Parsed row whose id still points into the source text.
+struct MeasurementView
+{
+    double time;
+    std::string_view id;
+    double x;
+    double y;
+    double speed;
+    double course_deg;
+};
+
+// All loaded tracks: series[id] holds the time-ordered measurements of
+// track `id`, whose external name is ids.name(id). Loaders number tracks in
+// lexicographic name order, so iterating 0..size() gives a stable order.
+struct TrackSeries
+{
+    TrackIdTable ids;
+    std::vector<std::vector<Measurement>> series;
+
+    std::size_t size() const { return series.size(); }
+    bool empty() const { return series.empty(); }
+    std::size_t num_rows() const;
+
+    // Track for name, created empty if new.
+    std::vector<Measurement>& track(std::string_view name);
+
+    // Renumber tracks (and the ids stored in every row) by name.
+    void sort_by_name();
+};
+
+class ThreadPool;
+
+// Parse one data row "time,id,x,y,speed,course" without allocating.
+// Malformed rows are reported to `err` and return false.
+bool parse_measurement_row(std::string_view line, MeasurementView& row,
+                           std::ostream& err = std::cerr);
+
+// Same, interning the id into `ids`.
+bool parse_measurement_line(const std::string& line, TrackIdTable& ids, Measurement& m);
+
 // CSV format:
 // time,id,x,y,speed,course
-// return: id -> vector measurements by time
-bool load_timeseries_from_csv(const std::string& path,
-                              std::map<std::string, std::vector<Measurement>>& out);
+// return: per-track vectors of measurements by time
+// The file is memory-mapped and parsed in place; rows only allocate when
+// a new id appears or a series grows. Series that are already time-ordered
+// are not re-sorted; ties keep file order.
+bool load_timeseries_from_csv(const std::string& path, TrackSeries& out);
+
+// Same result, but the file is cut into slices at newline boundaries that
+// are parsed on the pool's threads; the per-slice pieces of each id are
+// then merged (k-way when each piece is ordered).
+bool load_timeseries_from_csv_parallel(const std::string& path,
+                                       TrackSeries& out,
+                                       ThreadPool& pool);
 
 std::string trim_copy(const std::string& s);
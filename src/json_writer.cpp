@@ -1,98 +1,346 @@
 #include "json_writer.h"
+#include "scan.h"
+#include "smoother.h"
 
-#include <fstream>
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
 #include <iostream>
-#include <iomanip>
 
-void write_json(
+JsonOut::JsonOut(std::ostream& os, std::size_t capacity)
+    : os_(os), buf_(capacity < MIN_CAPACITY ? MIN_CAPACITY : capacity)
+{
+}
+
+JsonOut::~JsonOut()
+{
+    flush();
+}
+
+void JsonOut::flush()
+{
+    if (len_ > 0)
+    {
+        os_.write(buf_.data(), static_cast<std::streamsize>(len_));
+        len_ = 0;
+    }
+    os_.flush();
+}
+
+void JsonOut::reserve(std::size_t n)
+{
+    if (len_ + n > buf_.size())
+    {
+        os_.write(buf_.data(), static_cast<std::streamsize>(len_));
+        len_ = 0;
+    }
+}
+
+JsonOut& JsonOut::raw(std::string_view s)
+{
+    if (s.size() > buf_.size())
+    {
+        reserve(buf_.size());
+        os_.write(s.data(), static_cast<std::streamsize>(s.size()));
+        return *this;
+    }
+    reserve(s.size());
+    std::memcpy(buf_.data() + len_, s.data(), s.size());
+    len_ += s.size();
+    return *this;
+}
+
+JsonOut& JsonOut::raw(char c)
+{
+    reserve(1);
+    buf_[len_++] = c;
+    return *this;
+}
+
+JsonOut& JsonOut::str(std::string_view s)
+{
+    static const char hex[] = "0123456789abcdef";
+    raw('"');
+    for (char c : s)
+    {
+        unsigned char u = static_cast<unsigned char>(c);
+        if (c == '"' || c == '\\')
+        {
+            reserve(2);
+            buf_[len_++] = '\\';
+            buf_[len_++] = c;
+        }
+        else if (u < 0x20)
+        {
+            reserve(6);
+            std::memcpy(buf_.data() + len_, "\\u00", 4);
+            buf_[len_ + 4] = hex[u >> 4];
+            buf_[len_ + 5] = hex[u & 0xF];
+            len_ += 6;
+        }
+        else
+        {
+            raw(c);
+        }
+    }
+    return raw('"');
+}
+
+JsonOut& JsonOut::num(double v, int decimals)
+{
+    // JSON has no NaN / infinity
+    if (!std::isfinite(v)) return raw(std::string_view("null"));
+
+    // fixed notation of the largest double is ~310 digits
+    decimals = std::clamp(decimals, 0, MAX_DECIMALS);
+    reserve(328 + static_cast<std::size_t>(decimals));
+    char* first = buf_.data() + len_;
+    auto res = std::to_chars(first, buf_.data() + buf_.size(), v, std::chars_format::fixed, decimals);
+    if (res.ec != std::errc())
+        return raw(std::string_view("null"));
+    len_ += static_cast<std::size_t>(res.ptr - first);
+    return *this;
+}
+
+JsonOut& JsonOut::integer(std::uint64_t v)
+{
+    reserve(20);
+    char* first = buf_.data() + len_;
+    auto res = std::to_chars(first, buf_.data() + buf_.size(), v);
+    if (res.ec != std::errc())
+        return raw(std::string_view("null"));
+    len_ += static_cast<std::size_t>(res.ptr - first);
+    return *this;
+}
+
+JsonOut& JsonOut::boolean(bool b)
+{
+    return raw(b ? std::string_view("true") : std::string_view("false"));
+}
+
+bool write_json(
     const std::string& path,
-    const std::map<std::string, std::vector<Measurement>>& series,
-    const std::map<std::string, CpaResult>& final_results,
-    const std::map<std::string, Vec2>& final_positions,
-    const std::map<std::string, Vec2>& final_velocities,
+    const TrackSeries& series,
+    const std::vector<CpaResult>& final_results,
+    const std::vector<Vec2>& final_positions,
+    const std::vector<Vec2>& final_velocities,
     const Vec2& own_pos,
-    const Vec2& own_vel)
+    const Vec2& own_vel,
+    const std::vector<double>* p_collision)
 {
-    std::ofstream out(path);
-    if (!out)
+    std::ofstream file(path, std::ios::binary);
+    if (!file)
     {
         std::cerr << "Failed to open JSON file for writing: " << path << "\n";
-        return;
+        return false;
     }
 
-    out << std::fixed << std::setprecision(3);
-    out << "{\n";
+    {
+        JsonOut out(file, 1 << 20);
+        out.raw("{\n");
 
-    // ownship block
-    out << "  \"ownship\": {\n";
-    out << "    \"position\": { \"x\": " << own_pos.x
-        << ", \"y\": " << own_pos.y << " },\n";
-    out << "    \"velocity\": { \"vx\": " << own_vel.x
-        << ", \"vy\": " << own_vel.y << " }\n";
-    out << "  },\n";
+        // ownship block
+        out.raw("  \"ownship\": {\n");
+        out.raw("    \"position\": { \"x\": ").num(own_pos.x)
+           .raw(", \"y\": ").num(own_pos.y).raw(" },\n");
+        out.raw("    \"velocity\": { \"vx\": ").num(own_vel.x)
+           .raw(", \"vy\": ").num(own_vel.y).raw(" }\n");
+        out.raw("  },\n");
 
-    // targets
-    out << "  \"targets\": [\n";
+        // targets
+        out.raw("  \"targets\": [\n");
 
-    bool first_target = true;
-    for (const auto& kv : series)
-    {
-        const std::string& id = kv.first;
-        const auto& seq = kv.second;
+        for (TrackId id = 0; id < series.size(); ++id)
+        {
+            const auto& seq = series.series[id];
 
-        if (!first_target)
-            out << ",\n";
-        first_target = false;
+            if (id != 0)
+                out.raw(",\n");
 
-        const auto& cpa = final_results.at(id);
-        const auto& pos = final_positions.at(id);
-        const auto& vel = final_velocities.at(id);
+            const auto& cpa = final_results[id];
+            const auto& pos = final_positions[id];
+            const auto& vel = final_velocities[id];
 
-        out << "    {\n";
-        out << "      \"id\": \"" << id << "\",\n";
+            out.raw("    {\n");
+            out.raw("      \"id\": ").str(series.ids.name(id)).raw(",\n");
 
-        // measurements array
-        out << "      \"measurements\": [\n";
-        for (std::size_t i = 0; i < seq.size(); ++i)
-        {
-            const auto& m = seq[i];
-            out << "        { "
-                << "\"time\": " << m.time
-                << ", \"x\": " << m.x
-                << ", \"y\": " << m.y
-                << ", \"speed\": " << m.speed
-                << ", \"course\": " << m.course_deg
-                << " }";
-            if (i + 1 != seq.size()) out << ",";
-            out << "\n";
+            // measurements array
+            out.raw("      \"measurements\": [\n");
+            for (std::size_t i = 0; i < seq.size(); ++i)
+            {
+                const auto& m = seq[i];
+                out.raw("        { \"time\": ").num(m.time)
+                   .raw(", \"x\": ").num(m.x)
+                   .raw(", \"y\": ").num(m.y)
+                   .raw(", \"speed\": ").num(m.speed)
+                   .raw(", \"course\": ").num(m.course_deg)
+                   .raw(" }");
+                if (i + 1 != seq.size()) out.raw(',');
+                out.raw('\n');
+            }
+            out.raw("      ],\n");
+
+            // filtered state
+            out.raw("      \"filtered_state\": {\n");
+            out.raw("        \"x\": ").num(pos.x).raw(",\n");
+            out.raw("        \"y\": ").num(pos.y).raw(",\n");
+            out.raw("        \"vx\": ").num(vel.x).raw(",\n");
+            out.raw("        \"vy\": ").num(vel.y).raw('\n');
+            out.raw("      },\n");
+
+            // CPA info
+            out.raw("      \"cpa\": {\n");
+            out.raw("        \"distance\": ").num(cpa.cpa_distance).raw(",\n");
+            out.raw("        \"tcpa\": ").num(cpa.tcpa).raw(",\n");
+            out.raw("        \"collision_risk\": ").boolean(cpa.collision_risk).raw(",\n");
+            out.raw("        \"closing\": ").boolean(cpa.closing).raw(",\n");
+            out.raw("        \"valid\": ").boolean(cpa.valid);
+            if (p_collision)
+                out.raw(",\n        \"p_collision\": ").num((*p_collision)[id], 6);
+            out.raw('\n');
+            out.raw("      }\n");
+
+            out.raw("    }");
         }
-        out << "      ],\n";
-
-        // filtered state
-        out << "      \"filtered_state\": {\n";
-        out << "        \"x\": " << pos.x << ",\n";
-        out << "        \"y\": " << pos.y << ",\n";
-        out << "        \"vx\": " << vel.x << ",\n";
-        out << "        \"vy\": " << vel.y << "\n";
-        out << "      },\n";
-
-        // CPA info
-        out << "      \"cpa\": {\n";
-        out << "        \"distance\": " << cpa.cpa_distance << ",\n";
-        out << "        \"tcpa\": " << cpa.tcpa << ",\n";
-        out << "        \"collision_risk\": "
-            << (cpa.collision_risk ? "true" : "false") << ",\n";
-        out << "        \"closing\": "
-            << (cpa.closing ? "true" : "false") << ",\n";
-        out << "        \"valid\": "
-            << (cpa.valid ? "true" : "false") << "\n";
-        out << "      }\n";
-
-        out << "    ";
+
+        out.raw("\n  ]\n");
+        out.raw("}\n");
+    }
+
+    return static_cast<bool>(file);
+}
+
+namespace
+{
+
+void put_state_and_cpa(JsonOut& out, const Vec2& pos, const Vec2& vel, const CpaResult& cpa,
+                       const double* p_collision = nullptr)
+{
+    out.raw(",\"filtered_state\":{\"x\":").num(pos.x)
+       .raw(",\"y\":").num(pos.y)
+       .raw(",\"vx\":").num(vel.x)
+       .raw(",\"vy\":").num(vel.y)
+       .raw("},\"cpa\":{\"distance\":").num(cpa.cpa_distance)
+       .raw(",\"tcpa\":").num(cpa.tcpa)
+       .raw(",\"collision_risk\":").boolean(cpa.collision_risk)
+       .raw(",\"closing\":").boolean(cpa.closing)
+       .raw(",\"valid\":").boolean(cpa.valid);
+    if (p_collision)
+        out.raw(",\"p_collision\":").num(*p_collision, 6);
+    out.raw('}');
+}
+
+} // namespace
+
+bool NdjsonWriter::open(const std::string& path)
+{
+    out_.reset();
+    file_.reset();
+
+    if (path == "-")
+    {
+        out_.reset(new JsonOut(std::cout));
+        return true;
+    }
+
+    file_.reset(new std::ofstream(path, std::ios::binary));
+    if (!*file_)
+    {
+        std::cerr << "Failed to open NDJSON file for writing: " << path << "\n";
+        file_.reset();
+        return false;
+    }
+    out_.reset(new JsonOut(*file_, 1 << 20));
+    return true;
+}
+
+void NdjsonWriter::write_track(const std::string& id,
+                               const std::vector<Measurement>& seq,
+                               const Vec2& pos,
+                               const Vec2& vel,
+                               const CpaResult& cpa,
+                               const double* p_collision)
+{
+    JsonOut& out = *out_;
+    out.raw("{\"id\":").str(id).raw(",\"measurements\":[");
+    for (std::size_t i = 0; i < seq.size(); ++i)
+    {
+        const auto& m = seq[i];
+        if (i) out.raw(',');
+        out.raw("{\"time\":").num(m.time)
+           .raw(",\"x\":").num(m.x)
+           .raw(",\"y\":").num(m.y)
+           .raw(",\"speed\":").num(m.speed)
+           .raw(",\"course\":").num(m.course_deg)
+           .raw('}');
+    }
+    out.raw(']');
+    put_state_and_cpa(out, pos, vel, cpa, p_collision);
+    out.raw("}\n");
+}
+
+void NdjsonWriter::write_update(double time,
+                                const std::string& id,
+                                const Vec2& pos,
+                                const Vec2& vel,
+                                const CpaResult& cpa)
+{
+    JsonOut& out = *out_;
+    out.raw("{\"time\":").num(time).raw(",\"id\":").str(id);
+    put_state_and_cpa(out, pos, vel, cpa);
+    out.raw("}\n");
+}
+
+void NdjsonWriter::write_scan(const ScanSnapshot& snap, const TrackIdTable& ids)
+{
+    JsonOut& out = *out_;
+    out.raw("{\"time\":").num(snap.time)
+       .raw(",\"measurements\":").integer(snap.measurements)
+       .raw(",\"live\":").integer(snap.live->size())
+       .raw(",\"risks\":").integer(snap.risks)
+       .raw(",\"min_cpa\":");
+    if (snap.has_min_cpa)
+        out.raw("{\"id\":").str(ids.name(snap.min_cpa_id))
+           .raw(",\"distance\":").num(snap.min_cpa).raw('}');
+    else
+        out.raw("null");
+
+    out.raw(",\"risk_ids\":[");
+    bool first = true;
+    for (std::size_t k = 0; k < snap.live->size(); ++k)
+    {
+        if (!snap.cpa->collision_risk[k]) continue;
+        if (!first) out.raw(',');
+        first = false;
+        out.str(ids.name((*snap.live)[k]));
     }
+    out.raw("]}\n");
+}
 
-    out << "\n  ]\n";
-    out << "}\n";
+void NdjsonWriter::write_smoothed(const std::string& id, const SmoothedTrack& track)
+{
+    JsonOut& out = *out_;
+    out.raw("{\"id\":").str(id).raw(",\"smoothed\":[");
+    for (std::size_t i = 0; i < track.points.size(); ++i)
+    {
+        const SmoothedPoint& p = track.points[i];
+        const CpaResultBlock& c = track.cpa;
+        if (i) out.raw(',');
+        out.raw("{\"time\":").num(p.time)
+           .raw(",\"x\":").num(p.state.pos.x)
+           .raw(",\"y\":").num(p.state.pos.y)
+           .raw(",\"vx\":").num(p.state.vel.x)
+           .raw(",\"vy\":").num(p.state.vel.y)
+           .raw(",\"cpa\":").num(c.cpa_distance[i])
+           .raw(",\"tcpa\":").num(c.tcpa[i])
+           .raw(",\"collision_risk\":").boolean(c.collision_risk[i] != 0)
+           .raw('}');
+    }
+    out.raw("]}\n");
+}
 
-    std::cout << "JSON saved to " << path << "\n";
+void NdjsonWriter::flush()
+{
+    if (out_) out_->flush();
 }
@@ -1,19 +1,101 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <ostream>
 #include <string>
-#include <map>
+#include <string_view>
 #include <vector>
 
 #include "io.h"
 #include "cpa.h"
 
-// Serialize results to a JSON file.
-void write_json(
+struct ScanSnapshot;
+struct SmoothedTrack;
+
+// Formats JSON into a fixed buffer with std::to_chars and hands it to the
+// stream in large blocks; nothing is allocated per field. Numbers that
+// cannot be written (NaN, infinity) come out as null.
+class JsonOut
+{
+public:
+    static constexpr std::size_t MIN_CAPACITY = 512;  // holds any num()
+    static constexpr int MAX_DECIMALS = 17;
+
+    explicit JsonOut(std::ostream& os, std::size_t capacity = 1 << 16);
+    ~JsonOut();
+
+    JsonOut(const JsonOut&) = delete;
+    JsonOut& operator=(const JsonOut&) = delete;
+
+    JsonOut& raw(std::string_view s);
+    JsonOut& raw(char c);
+    JsonOut& str(std::string_view s);   // quoted and escaped
+    JsonOut& num(double v, int decimals = 3);  // fixed notation
+    JsonOut& integer(std::uint64_t v);
+    JsonOut& boolean(bool b);
+
+    void flush();
+
+private:
+    void reserve(std::size_t n);
+
+    std::ostream& os_;
+    std::vector<char> buf_;
+    std::size_t len_{0};
+};
+
+// Serialize results to a JSON file. Result vectors are indexed by TrackId;
+// p_collision, when given, adds the collision probability to each target.
+// Returns false (reported to stderr) if the file cannot be written.
+bool write_json(
     const std::string& path,
-    const std::map<std::string, std::vector<Measurement>>& series,
-    const std::map<std::string, CpaResult>& final_results,
-    const std::map<std::string, Vec2>& final_positions,
-    const std::map<std::string, Vec2>& final_velocities,
+    const TrackSeries& series,
+    const std::vector<CpaResult>& final_results,
+    const std::vector<Vec2>& final_positions,
+    const std::vector<Vec2>& final_velocities,
     const Vec2& own_pos,
-    const Vec2& own_vel
+    const Vec2& own_vel,
+    const std::vector<double>* p_collision = nullptr
 );
+
+// Newline-delimited JSON: one self-contained object per line, written as
+// soon as it is produced. Path "-" writes to stdout; callers then leave out
+// their text output (see to_stdout) so that stdout stays parseable.
+class NdjsonWriter
+{
+public:
+    bool open(const std::string& path);
+    bool is_open() const { return out_ != nullptr; }
+    bool to_stdout() const { return out_ != nullptr && file_ == nullptr; }
+
+    // Final result of one track, with its measurements (and its collision
+    // probability when p_collision is given).
+    void write_track(const std::string& id,
+                     const std::vector<Measurement>& seq,
+                     const Vec2& pos,
+                     const Vec2& vel,
+                     const CpaResult& cpa,
+                     const double* p_collision = nullptr);
+
+    // One filter update in a streaming run.
+    void write_update(double time,
+                      const std::string& id,
+                      const Vec2& pos,
+                      const Vec2& vel,
+                      const CpaResult& cpa);
+
+    // Summary of one scan with the ids of the tracks at risk.
+    void write_scan(const ScanSnapshot& snap, const TrackIdTable& ids);
+
+    // Smoothed trajectory of one track with the CPA at every step.
+    void write_smoothed(const std::string& id, const SmoothedTrack& track);
+
+    void flush();
+
+private:
+    std::unique_ptr<std::ofstream> file_;
+    std::unique_ptr<JsonOut> out_;
+};
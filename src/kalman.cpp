@@ -1,153 +1,391 @@
 #include "kalman.h"
 
-KalmanFilter2D::KalmanFilter2D()
+#include <algorithm>
+
+namespace
+{
+
+bool same_dt(double a, double b)
+{
+    return std::fabs(a - b) <= 1e-9 * std::max(1.0, std::fabs(b));
+}
+
+// max |A - B| relative to the larger of 1 and max |B|
+template <int N>
+double rel_diff(const double A[N][N], const double B[N][N])
+{
+    double diff = 0.0, scale = 1.0;
+    for (int i = 0; i < N; ++i)
+        for (int j = 0; j < N; ++j)
+        {
+            diff  = std::max(diff, std::fabs(A[i][j] - B[i][j]));
+            scale = std::max(scale, std::fabs(B[i][j]));
+        }
+    return diff / scale;
+}
+
+// In place inverse by Gauss-Jordan elimination with partial pivoting;
+// false if A is (numerically) singular.
+template <int N>
+bool invert(double A[N][N])
 {
-    for (int i = 0; i < 4; ++i)
+    double inv[N][N] = {};
+    for (int i = 0; i < N; ++i) inv[i][i] = 1.0;
+
+    for (int c = 0; c < N; ++c)
     {
-        x[i] = 0.0;
-        for (int j = 0; j < 4; ++j)
+        int p = c;
+        for (int r = c + 1; r < N; ++r)
+            if (std::fabs(A[r][c]) > std::fabs(A[p][c])) p = r;
+        if (!(std::fabs(A[p][c]) > 1e-300)) return false;
+        if (p != c)
+            for (int j = 0; j < N; ++j)
+            {
+                std::swap(A[p][j], A[c][j]);
+                std::swap(inv[p][j], inv[c][j]);
+            }
+
+        const double d = 1.0 / A[c][c];
+        for (int j = 0; j < N; ++j)
         {
-            P[i][j] = 0.0;
-            Q[i][j] = 0.0;
+            A[c][j] *= d;
+            inv[c][j] *= d;
+        }
+        for (int r = 0; r < N; ++r)
+        {
+            if (r == c || A[r][c] == 0.0) continue;
+            const double f = A[r][c];
+            for (int j = 0; j < N; ++j)
+            {
+                A[r][j] -= f * A[c][j];
+                inv[r][j] -= f * inv[c][j];
+            }
         }
     }
-    for (int r = 0; r < 2; ++r)
-        for (int c = 0; c < 4; ++c)
-            H[r][c] = 0.0;
-    H[0][0] = 1.0;
-    H[1][1] = 1.0;
 
-    R[0][0] = 25.0; R[0][1] = 0.0;
-    R[1][0] = 0.0;  R[1][1] = 25.0;
+    for (int i = 0; i < N; ++i)
+        for (int j = 0; j < N; ++j)
+            A[i][j] = inv[i][j];
+    return true;
+}
 
-    for (int i = 0; i < 4; ++i) Q[i][i] = 0.1;
+template <int N>
+void matmul(const double A[N][N], const double B[N][N], double C[N][N])
+{
+    for (int i = 0; i < N; ++i)
+        for (int j = 0; j < N; ++j)
+        {
+            double s = 0.0;
+            for (int k = 0; k < N; ++k) s += A[i][k] * B[k][j];
+            C[i][j] = s;
+        }
 }
 
-void KalmanFilter2D::init(double x0, double y0, double vx0, double vy0)
+// Steady prior covariance P of the filter's discrete Riccati equation
+//     P = F P F^T - F P H^T (H P H^T + R)^-1 H P F^T + Q,   H = [I 0]
+// by the structured doubling algorithm, with A0 = F^T, G0 = H^T R^-1 H and
+// H0 = Q:
+//     W = (I + G H)^-1,  A' = A W A,  G' = G + A W G A^T,  H' = H + A^T H W A
+// H converges quadratically to P, so a few dozen steps cover any dt that
+// the plain recursion would need 10^5 steps for.
+template <class Model>
+bool riccati_doubling(double dt, const double Q[Model::N][Model::N], const double R[2][2],
+                      double P[Model::N][Model::N])
 {
-    x[0] = x0; x[1] = y0; x[2] = vx0; x[3] = vy0;
+    constexpr int N = Model::N;
 
-    for (int i = 0; i < 4; ++i)
-        for (int j = 0; j < 4; ++j)
-            P[i][j] = 0.0;
+    double F[N][N] = {};
+    double x0[N] = {};
+    Model::transition(x0, dt, F);
 
-    P[0][0] = 10.0;
-    P[1][1] = 10.0;
-    P[2][2] = 100.0;
-    P[3][3] = 100.0;
+    double A[N][N], G[N][N] = {}, H[N][N];
+    for (int i = 0; i < N; ++i)
+        for (int j = 0; j < N; ++j)
+        {
+            A[i][j] = F[j][i];
+            H[i][j] = Q[i][j];
+        }
+
+    const double det = R[0][0] * R[1][1] - R[0][1] * R[1][0];
+    if (!(std::fabs(det) > 0.0)) return false;
+    G[0][0] =  R[1][1] / det;  G[0][1] = -R[0][1] / det;
+    G[1][0] = -R[1][0] / det;  G[1][1] =  R[0][0] / det;
+
+    for (int it = 0; it < SteadyGainCache<Model>::MAX_DOUBLINGS; ++it)
+    {
+        double W[N][N];
+        matmul<N>(G, H, W);
+        for (int i = 0; i < N; ++i) W[i][i] += 1.0;
+        if (!invert<N>(W)) return false;
+
+        double AW[N][N], AWA[N][N], AWG[N][N], At[N][N];
+        matmul<N>(A, W, AW);
+        matmul<N>(AW, A, AWA);
+        matmul<N>(AW, G, AWG);
+        for (int i = 0; i < N; ++i)
+            for (int j = 0; j < N; ++j)
+                At[i][j] = A[j][i];
+
+        double Gn[N][N], Hn[N][N], T[N][N], U[N][N];
+        matmul<N>(AWG, At, T);
+        for (int i = 0; i < N; ++i)
+            for (int j = 0; j < N; ++j)
+                Gn[i][j] = G[i][j] + T[i][j];
+        // A^T H W A = A^T H (W A)
+        double WA[N][N];
+        matmul<N>(W, A, WA);
+        matmul<N>(H, WA, T);
+        matmul<N>(At, T, U);
+        for (int i = 0; i < N; ++i)
+            for (int j = 0; j < N; ++j)
+                Hn[i][j] = H[i][j] + U[i][j];
+
+        const double change = rel_diff<N>(Hn, H);
+        for (int i = 0; i < N; ++i)
+            for (int j = 0; j < N; ++j)
+            {
+                A[i][j] = AWA[i][j];
+                G[i][j] = Gn[i][j];
+                // keep the iterate exactly symmetric
+                H[i][j] = 0.5 * (Hn[i][j] + Hn[j][i]);
+            }
+        if (!std::isfinite(change)) return false;
+        if (change < 1e-15)
+        {
+            for (int i = 0; i < N; ++i)
+                for (int j = 0; j < N; ++j)
+                    P[i][j] = H[i][j];
+            return true;
+        }
+    }
+    return false;
 }
 
-void KalmanFilter2D::predict(double dt)
+} // namespace
+
+template <class Model>
+KalmanFilter<Model>::KalmanFilter()
 {
-    // F
-    double F[4][4] = {
-        {1.0, 0.0, dt,  0.0},
-        {0.0, 1.0, 0.0, dt },
-        {0.0, 0.0, 1.0, 0.0},
-        {0.0, 0.0, 0.0, 1.0}
-    };
+    for (int i = 0; i < N; ++i)
+    {
+        x[i] = 0.0;
+        for (int j = 0; j < N; ++j)
+        {
+            P[i][j] = 0.0;
+            Q[i][j] = 0.0;
+        }
+    }
 
-    // x = F*x
-    double nx[4] = {0,0,0,0};
-    for (int i = 0; i < 4; ++i)
-        for (int j = 0; j < 4; ++j)
-            nx[i] += F[i][j] * x[j];
-    for (int i = 0; i < 4; ++i) x[i] = nx[i];
-
-    // P = FPF^T + Q
-    double FP[4][4] = {0};
-    for (int i = 0; i < 4; ++i)
-        for (int j = 0; j < 4; ++j)
-            for (int k = 0; k < 4; ++k)
-                FP[i][j] += F[i][k] * P[k][j];
+    R[0][0] = 25.0; R[0][1] = 0.0;
+    R[1][0] = 0.0;  R[1][1] = 25.0;
 
-    double FPFt[4][4] = {0};
-    for (int i = 0; i < 4; ++i)
-        for (int j = 0; j < 4; ++j)
-            for (int k = 0; k < 4; ++k)
-                FPFt[i][j] += FP[i][k] * F[j][k]; // F^T
+    for (int i = 0; i < N; ++i) Q[i][i] = Model::process_var(i);
+}
 
-    for (int i = 0; i < 4; ++i)
-        for (int j = 0; j < 4; ++j)
-            P[i][j] = FPFt[i][j] + Q[i][j];
+template <class Model>
+void KalmanFilter<Model>::init(double x0, double y0, double vx0, double vy0)
+{
+    for (int i = 0; i < N; ++i)
+    {
+        x[i] = 0.0;
+        for (int j = 0; j < N; ++j)
+            P[i][j] = 0.0;
+        P[i][i] = Model::initial_var(i);
+    }
+    x[0] = x0; x[1] = y0; x[2] = vx0; x[3] = vy0;
+    steady_ = false;
+    dt_repeats_ = 0;
 }
 
-void KalmanFilter2D::update(double zx, double zy)
+template <class Model>
+void KalmanFilter<Model>::predict(double dt)
 {
-    double z[2] = {zx, zy};
+    if constexpr (Model::linear)
+    {
+        if (steady_)
+        {
+            if (same_dt(dt, steady_dt_))
+            {
+                Model::propagate(x, dt);
+                return;
+            }
+            // P still holds the steady-state posterior; resume the recursion
+            steady_ = false;
+        }
+    }
+    dt_repeats_ = (dt_repeats_ > 0 && same_dt(dt, last_dt_)) ? dt_repeats_ + 1 : 1;
+    last_dt_ = dt;
 
-    // y = z - Hx
-    double Hx[2] = {0,0};
-    for (int i = 0; i < 2; ++i)
-        for (int j = 0; j < 4; ++j)
-            Hx[i] += H[i][j] * x[j];
+    // F (the Jacobian at the prior state for nonlinear models)
+    double F[N][N] = {};
+    Model::transition(x, dt, F);
 
-    double yv[2] = { z[0] - Hx[0], z[1] - Hx[1] };
+    Model::propagate(x, dt);
 
-    // S = HPH^T + R
-    double HP[2][4] = {0};
-    for (int i = 0; i < 2; ++i)
-        for (int j = 0; j < 4; ++j)
-            for (int k = 0; k < 4; ++k)
-                HP[i][j] += H[i][k] * P[k][j];
+    // P = FPF^T + Q over the nonzero entries of F
+    double FP[N][N] = {};
+    for (int i = 0; i < N; ++i)
+        for (int k = 0; k < N; ++k)
+        {
+            if (!Model::F_nz(i, k)) continue;
+            for (int j = 0; j < N; ++j)
+                FP[i][j] += F[i][k] * P[k][j];
+        }
 
-    double HPHt[2][2] = {0};
-    for (int i = 0; i < 2; ++i)
-        for (int j = 0; j < 2; ++j)
-            for (int k = 0; k < 4; ++k)
-                HPHt[i][j] += HP[i][k] * H[j][k];
+    for (int i = 0; i < N; ++i)
+        for (int j = 0; j < N; ++j)
+        {
+            double s = 0.0;
+            for (int k = 0; k < N; ++k)
+                if (Model::F_nz(j, k))
+                    s += FP[i][k] * F[j][k]; // F^T
+            P[i][j] = s + Q[i][j];
+        }
+}
 
-    double S[2][2] = {
-        { HPHt[0][0] + R[0][0], HPHt[0][1] + R[0][1] },
-        { HPHt[1][0] + R[1][0], HPHt[1][1] + R[1][1] }
+template <class Model>
+bool KalmanFilter<Model>::gain(double K[N][2]) const
+{
+    // S = HPH^T + R, H picks [x, y]
+    const double S[2][2] = {
+        { P[0][0] + R[0][0], P[0][1] + R[0][1] },
+        { P[1][0] + R[1][0], P[1][1] + R[1][1] }
     };
 
     // inv(S)
     double det = S[0][0]*S[1][1] - S[0][1]*S[1][0];
-    if (std::fabs(det) < 1e-9) return;
+    if (std::fabs(det) < 1e-9) return false;
     double invDet = 1.0 / det;
     double invS[2][2] = {
         {  S[1][1]*invDet, -S[0][1]*invDet },
         { -S[1][0]*invDet,  S[0][0]*invDet }
     };
 
-    // K = P H^T invS
-    double PHt[4][2] = {0};
-    for (int i = 0; i < 4; ++i)
+    // K = P H^T invS, P H^T being the first two columns of P
+    for (int i = 0; i < N; ++i)
         for (int j = 0; j < 2; ++j)
-            for (int k = 0; k < 4; ++k)
-                PHt[i][j] += P[i][k] * H[j][k];
+            K[i][j] = P[i][0] * invS[0][j] + P[i][1] * invS[1][j];
+    return true;
+}
 
-    double K[4][2] = {0};
-    for (int i = 0; i < 4; ++i)
-        for (int j = 0; j < 2; ++j)
-            for (int k = 0; k < 2; ++k)
-                K[i][j] += PHt[i][k] * invS[k][j];
+template <class Model>
+void KalmanFilter<Model>::update(double zx, double zy)
+{
+    // y = z - Hx
+    const double yv[2] = { zx - x[0], zy - x[1] };
+
+    const double (*Kc)[2] = nullptr;
+    double K[N][2];
+    if (steady_)
+    {
+        Kc = steady_K_;
+    }
+    else
+    {
+        if (!gain(K)) return;
+        Kc = K;
+    }
 
     // x = x + K y
-    for (int i = 0; i < 4; ++i)
+    for (int i = 0; i < N; ++i)
+        x[i] += Kc[i][0] * yv[0] + Kc[i][1] * yv[1];
+
+    if (steady_) return;  // P stays at the steady-state posterior
+
+    // P = (I - K H) P; HP is the first two rows of P
+    double HP[2][N];
+    for (int j = 0; j < N; ++j)
+    {
+        HP[0][j] = P[0][j];
+        HP[1][j] = P[1][j];
+    }
+    for (int i = 0; i < N; ++i)
+        for (int j = 0; j < N; ++j)
+            P[i][j] -= K[i][0] * HP[0][j] + K[i][1] * HP[1][j];
+
+    // switch to the constant gain once P has settled for this dt
+    if constexpr (Model::linear)
+    {
+        // a dt seen only once or twice (jitter) is not worth solving for
+        if (gains_ && dt_repeats_ >= STEADY_REPEATS)
+        {
+            const SteadyGain<Model>* g = gains_->get(last_dt_, *this);
+            if (g->converged && rel_diff<N>(P, g->P) < 1e-9)
+            {
+                for (int i = 0; i < N; ++i)
+                {
+                    for (int j = 0; j < N; ++j)
+                        P[i][j] = g->P[i][j];
+                    steady_K_[i][0] = g->K[i][0];
+                    steady_K_[i][1] = g->K[i][1];
+                }
+                steady_dt_ = g->dt;
+                steady_ = true;
+            }
+        }
+    }
+}
+
+template <class Model>
+const SteadyGain<Model>* SteadyGainCache<Model>::get(double dt, const KalmanFilter<Model>& model)
+{
+    constexpr int N = Model::N;
+
+    if (last_ < entries_.size() && same_dt(dt, entries_[last_].dt))
+    {
+        used_[last_] = ++clock_;
+        return &entries_[last_];
+    }
+    for (std::size_t k = 0; k < entries_.size(); ++k)
+        if (same_dt(dt, entries_[k].dt))
+        {
+            last_ = k;
+            used_[k] = ++clock_;
+            return &entries_[k];
+        }
+
+    // new interval: a free slot or the least recently used one
+    std::size_t k = entries_.size();
+    if (k < max_entries)
+    {
+        entries_.emplace_back();
+        used_.push_back(0);
+    }
+    else
+    {
+        k = static_cast<std::size_t>(std::min_element(used_.begin(), used_.end()) - used_.begin());
+    }
+    last_ = k;
+    used_[k] = ++clock_;
+    ++solves_;
+
+    SteadyGain<Model>& g = entries_[k];
+    g = SteadyGain<Model>{};
+    g.dt = dt;
+
+    // without motion between samples the velocity variance never settles
+    if (!(dt > 0.0)) return &g;
+
+    KalmanFilter<Model> kf;
+    for (int i = 0; i < N; ++i)
+        for (int j = 0; j < N; ++j)
+            kf.Q[i][j] = model.Q[i][j];
+    for (int i = 0; i < 2; ++i)
         for (int j = 0; j < 2; ++j)
-            x[i] += K[i][j] * yv[j];
-
-    // P = (I - K H) P
-    double KH[4][4] = {0};
-    for (int i = 0; i < 4; ++i)
-        for (int j = 0; j < 4; ++j)
-            for (int k = 0; k < 2; ++k)
-                KH[i][j] += K[i][k] * H[k][j];
-
-    double IminusKH[4][4] = {0};
-    for (int i = 0; i < 4; ++i)
-        for (int j = 0; j < 4; ++j)
-            IminusKH[i][j] = (i==j?1.0:0.0) - KH[i][j];
-
-    double newP[4][4] = {0};
-    for (int i = 0; i < 4; ++i)
-        for (int j = 0; j < 4; ++j)
-            for (int k = 0; k < 4; ++k)
-                newP[i][j] += IminusKH[i][k] * P[k][j];
-
-    for (int i = 0; i < 4; ++i)
-        for (int j = 0; j < 4; ++j)
-            P[i][j] = newP[i][j];
+            kf.R[i][j] = model.R[i][j];
+
+    // steady prior, then its gain and the posterior it settles to
+    if (!riccati_doubling<Model>(dt, kf.Q, kf.R, kf.P)) return &g;
+    g.converged = kf.gain(g.K);
+    kf.update(0.0, 0.0);
+    for (int i = 0; i < N; ++i)
+        for (int j = 0; j < N; ++j)
+            g.P[i][j] = kf.P[i][j];
+    return &g;
 }
+
+template struct KalmanFilter<ConstantVelocity>;
+template struct KalmanFilter<ConstantAcceleration>;
+template struct KalmanFilter<CoordinatedTurn>;
+template class SteadyGainCache<ConstantVelocity>;
+template class SteadyGainCache<ConstantAcceleration>;
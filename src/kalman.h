@@ -1,23 +1,37 @@
 #pragma once
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "motion_models.h"
 
 // ref https://github.com/RahmadSadli/2-D-Kalman-Filter/blob/master/KalmanFilter.py
 
-struct KalmanFilter2D
+template <class Model> struct SteadyGain;
+template <class Model> class SteadyGainCache;
+
+// Kalman filter for one motion model (see motion_models.h). The state size
+// and the structure of F and H are compile-time constants, so the products
+// below only touch the nonzero entries. H observes [x, y]; nonlinear models
+// run as an EKF on the model's Jacobian.
+template <class Model>
+struct KalmanFilter
 {
-    // state x = [x, y, vx, vy]^T
-    double x[4];
-    // covariance 4x4
-    double P[4][4];
-    // measurement H (2x4): observe position only
-    double H[2][4];
+    static constexpr int N = Model::N;
+
+    // state, first four entries are [x, y, vx, vy]
+    double x[N];
+    // covariance NxN
+    double P[N][N];
     // measurement noise R (2x2)
     double R[2][2];
-    // process noise Q (4x4)
-    double Q[4][4];
+    // process noise Q (NxN)
+    double Q[N][N];
 
-    KalmanFilter2D();
+    KalmanFilter();
 
+    // Remaining states (acceleration, turn rate) start at zero.
     void init(double x0, double y0, double vx0, double vy0);
     void predict(double dt);
     void update(double zx, double zy);
@@ -26,4 +40,80 @@ struct KalmanFilter2D
     double getY() const { return x[1]; }
     double getVx() const { return x[2]; }
     double getVy() const { return x[3]; }
+
+    // Steady-state fast path (linear models only). With a cache attached,
+    // once the same dt has come STEADY_REPEATS times in a row and P has
+    // converged to the cached solution, the filter copies the constant gain
+    // and stops propagating P (x = Fx, x += K(z - Hx)). A different dt drops
+    // back to the full recursion from the steady-state P. Irregular sampling
+    // never consults the cache. The cache must match this filter's Q and R;
+    // nullptr turns it off.
+    static constexpr unsigned STEADY_REPEATS = 3;
+
+    template <class M = Model>
+    void set_gain_cache(SteadyGainCache<M>* cache)
+    {
+        static_assert(M::linear, "steady-state gain needs a linear model");
+        gains_ = cache;
+        steady_ = false;
+    }
+    bool is_steady() const { return steady_; }
+
+    // K = P H^T inv(HPH^T + R) from the current P; false if S is singular.
+    bool gain(double K[N][2]) const;
+
+private:
+    SteadyGainCache<Model>* gains_{nullptr};
+    bool steady_{false};
+    double steady_dt_{0.0};
+    double steady_K_[N][2];     // copied, so cache entries can be evicted
+    double last_dt_{0.0};
+    unsigned dt_repeats_{0};    // consecutive full steps with last_dt_
+};
+
+// Converged gain and posterior covariance for one sampling interval.
+template <class Model>
+struct SteadyGain
+{
+    double dt{0.0};
+    bool converged{false};
+    double K[Model::N][2]{};
+    double P[Model::N][Model::N]{};
 };
+
+// Steady-state gains keyed by dt, solved on first use with the structured
+// doubling algorithm for the filter's discrete Riccati equation (quadratic
+// convergence, at most MAX_DOUBLINGS steps however small dt is). Intervals
+// within a relative 1e-9 share an entry; beyond max_entries the least
+// recently used one is replaced. Not thread-safe: use one cache per thread.
+template <class Model>
+class SteadyGainCache
+{
+public:
+    static constexpr std::size_t max_entries = 16;
+    static constexpr int MAX_DOUBLINGS = 64;
+
+    // The returned entry stays valid until the next get().
+    const SteadyGain<Model>* get(double dt, const KalmanFilter<Model>& model);
+
+    std::size_t size() const { return entries_.size(); }
+    std::size_t solves() const { return solves_; }
+    void clear() { entries_.clear(); used_.clear(); }
+
+private:
+    std::vector<SteadyGain<Model>> entries_;
+    std::vector<std::uint64_t> used_;   // LRU stamps
+    std::uint64_t clock_{0};
+    std::size_t last_{0};               // most recent hit, checked first
+    std::size_t solves_{0};
+};
+
+// The original 4-state constant-velocity filter.
+using KalmanFilter2D = KalmanFilter<ConstantVelocity>;
+
+// Instantiated in kalman.cpp for the models in motion_models.h.
+extern template struct KalmanFilter<ConstantVelocity>;
+extern template struct KalmanFilter<ConstantAcceleration>;
+extern template struct KalmanFilter<CoordinatedTurn>;
+extern template class SteadyGainCache<ConstantVelocity>;
+extern template class SteadyGainCache<ConstantAcceleration>;
@@ -0,0 +1,236 @@
+#include "kalman_bank.h"
+#include "simd.h"
+
+namespace
+{
+
+template <class S>
+inline typename S::M active_mask(const std::uint8_t* active, std::size_t i)
+{
+    return active ? S::load_mask(active + i) : S::ge(S::set1(0.0), S::set1(0.0));
+}
+
+// P = F P F^T + Q with F = [I dt*I; 0 I]
+template <class S>
+inline void predict_lanes(KalmanBank& b, std::size_t i,
+                          const double* dt_in, const std::uint8_t* active)
+{
+    using V = typename S::V;
+    const typename S::M on = active_mask<S>(active, i);
+
+    const V dt = S::load(dt_in + i);
+    const V q  = S::set1(b.q);
+    const V two = S::set1(2.0);
+
+    const V x  = S::load(&b.x[i]);
+    const V y  = S::load(&b.y[i]);
+    const V vx = S::load(&b.vx[i]);
+    const V vy = S::load(&b.vy[i]);
+
+    const V p00 = S::load(&b.p00[i]), p01 = S::load(&b.p01[i]);
+    const V p02 = S::load(&b.p02[i]), p03 = S::load(&b.p03[i]);
+    const V p11 = S::load(&b.p11[i]), p12 = S::load(&b.p12[i]);
+    const V p13 = S::load(&b.p13[i]), p22 = S::load(&b.p22[i]);
+    const V p23 = S::load(&b.p23[i]), p33 = S::load(&b.p33[i]);
+
+    const V dt2 = dt * dt;
+
+    S::store(&b.x[i], S::select(on, x + dt * vx, x));
+    S::store(&b.y[i], S::select(on, y + dt * vy, y));
+
+    S::store(&b.p00[i], S::select(on, p00 + two * dt * p02 + dt2 * p22 + q, p00));
+    S::store(&b.p01[i], S::select(on, p01 + dt * (p03 + p12) + dt2 * p23, p01));
+    S::store(&b.p02[i], S::select(on, p02 + dt * p22, p02));
+    S::store(&b.p03[i], S::select(on, p03 + dt * p23, p03));
+    S::store(&b.p11[i], S::select(on, p11 + two * dt * p13 + dt2 * p33 + q, p11));
+    S::store(&b.p12[i], S::select(on, p12 + dt * p23, p12));
+    S::store(&b.p13[i], S::select(on, p13 + dt * p33, p13));
+    S::store(&b.p22[i], S::select(on, p22 + q, p22));
+    S::store(&b.p33[i], S::select(on, p33 + q, p33));
+}
+
+// P = F P F^T + Q with F = [I A; 0 T] (see KalmanBank::predict_turn)
+template <class S>
+inline void predict_turn_lanes(KalmanBank& b, std::size_t i,
+                               const double* a_in, const double* b_in,
+                               const double* c_in, const double* s_in,
+                               const std::uint8_t* active)
+{
+    using V = typename S::V;
+    const typename S::M on = active_mask<S>(active, i);
+
+    const V a = S::load(a_in + i), bb = S::load(b_in + i);
+    const V c = S::load(c_in + i), s = S::load(s_in + i);
+    const V q = S::set1(b.q);
+    const V two = S::set1(2.0);
+
+    const V x  = S::load(&b.x[i]);
+    const V y  = S::load(&b.y[i]);
+    const V vx = S::load(&b.vx[i]);
+    const V vy = S::load(&b.vy[i]);
+
+    const V p00 = S::load(&b.p00[i]), p01 = S::load(&b.p01[i]);
+    const V p02 = S::load(&b.p02[i]), p03 = S::load(&b.p03[i]);
+    const V p11 = S::load(&b.p11[i]), p12 = S::load(&b.p12[i]);
+    const V p13 = S::load(&b.p13[i]), p22 = S::load(&b.p22[i]);
+    const V p23 = S::load(&b.p23[i]), p33 = S::load(&b.p33[i]);
+
+    S::store(&b.x[i],  S::select(on, x + a * vx - bb * vy, x));
+    S::store(&b.y[i],  S::select(on, y + bb * vx + a * vy, y));
+    S::store(&b.vx[i], S::select(on, c * vx - s * vy, vx));
+    S::store(&b.vy[i], S::select(on, s * vx + c * vy, vy));
+
+    // A Pvv
+    const V m00 = a * p22 - bb * p23, m01 = a * p23 - bb * p33;
+    const V m10 = bb * p22 + a * p23, m11 = bb * p23 + a * p33;
+    // Ppv A^T
+    const V u00 = p02 * a - p03 * bb, u01 = p02 * bb + p03 * a;
+    const V u10 = p12 * a - p13 * bb, u11 = p12 * bb + p13 * a;
+    // A Pvv A^T
+    const V w00 = m00 * a - m01 * bb;
+    const V w01 = m00 * bb + m01 * a;
+    const V w11 = m10 * bb + m11 * a;
+
+    S::store(&b.p00[i], S::select(on, p00 + two * u00 + w00 + q, p00));
+    S::store(&b.p01[i], S::select(on, p01 + u01 + u10 + w01, p01));
+    S::store(&b.p11[i], S::select(on, p11 + two * u11 + w11 + q, p11));
+
+    // (Ppv + A Pvv) T^T
+    const V t00 = p02 + m00, t01 = p03 + m01;
+    const V t10 = p12 + m10, t11 = p13 + m11;
+    S::store(&b.p02[i], S::select(on, t00 * c - t01 * s, p02));
+    S::store(&b.p03[i], S::select(on, t00 * s + t01 * c, p03));
+    S::store(&b.p12[i], S::select(on, t10 * c - t11 * s, p12));
+    S::store(&b.p13[i], S::select(on, t10 * s + t11 * c, p13));
+
+    // T Pvv T^T
+    const V r00 = c * p22 - s * p23, r01 = c * p23 - s * p33;
+    const V r10 = s * p22 + c * p23, r11 = s * p23 + c * p33;
+    S::store(&b.p22[i], S::select(on, r00 * c - r01 * s + q, p22));
+    S::store(&b.p23[i], S::select(on, r00 * s + r01 * c, p23));
+    S::store(&b.p33[i], S::select(on, r10 * s + r11 * c + q, p33));
+}
+
+// Position-only update with R = r*I. Lanes whose innovation covariance is
+// singular are skipped, matching KalmanFilter2D::update.
+template <class S>
+inline void update_lanes(KalmanBank& b, std::size_t i,
+                         const double* zx_in, const double* zy_in,
+                         const std::uint8_t* active,
+                         double* nis, double* det_s)
+{
+    using V = typename S::V;
+
+    const V r = S::set1(b.r);
+
+    const V p00 = S::load(&b.p00[i]), p01 = S::load(&b.p01[i]);
+    const V p02 = S::load(&b.p02[i]), p03 = S::load(&b.p03[i]);
+    const V p11 = S::load(&b.p11[i]), p12 = S::load(&b.p12[i]);
+    const V p13 = S::load(&b.p13[i]), p22 = S::load(&b.p22[i]);
+    const V p23 = S::load(&b.p23[i]), p33 = S::load(&b.p33[i]);
+
+    // S = H P H^T + R
+    const V s00 = p00 + r;
+    const V s01 = p01;
+    const V s11 = p11 + r;
+    const V det = s00 * s11 - s01 * s01;
+
+    const typename S::M on = S::land(active_mask<S>(active, i),
+                                     S::ge(S::abs(det), S::set1(1e-9)));
+
+    const V inv  = S::set1(1.0) / S::select(on, det, S::set1(1.0));
+    const V is00 =  s11 * inv;
+    const V is01 = -s01 * inv;
+    const V is11 =  s00 * inv;
+
+    // K = P H^T inv(S)
+    const V k00 = p00 * is00 + p01 * is01, k01 = p00 * is01 + p01 * is11;
+    const V k10 = p01 * is00 + p11 * is01, k11 = p01 * is01 + p11 * is11;
+    const V k20 = p02 * is00 + p12 * is01, k21 = p02 * is01 + p12 * is11;
+    const V k30 = p03 * is00 + p13 * is01, k31 = p03 * is01 + p13 * is11;
+
+    const V x  = S::load(&b.x[i]);
+    const V y  = S::load(&b.y[i]);
+    const V vx = S::load(&b.vx[i]);
+    const V vy = S::load(&b.vy[i]);
+
+    const V e0 = S::load(zx_in + i) - x;
+    const V e1 = S::load(zy_in + i) - y;
+
+    if (nis)
+        S::store(nis + i, e0 * (is00 * e0 + is01 * e1) + e1 * (is01 * e0 + is11 * e1));
+    if (det_s)
+        S::store(det_s + i, det);
+
+    S::store(&b.x[i],  S::select(on, x  + k00 * e0 + k01 * e1, x));
+    S::store(&b.y[i],  S::select(on, y  + k10 * e0 + k11 * e1, y));
+    S::store(&b.vx[i], S::select(on, vx + k20 * e0 + k21 * e1, vx));
+    S::store(&b.vy[i], S::select(on, vy + k30 * e0 + k31 * e1, vy));
+
+    // P = (I - K H) P
+    S::store(&b.p00[i], S::select(on, p00 - k00 * p00 - k01 * p01, p00));
+    S::store(&b.p01[i], S::select(on, p01 - k00 * p01 - k01 * p11, p01));
+    S::store(&b.p02[i], S::select(on, p02 - k00 * p02 - k01 * p12, p02));
+    S::store(&b.p03[i], S::select(on, p03 - k00 * p03 - k01 * p13, p03));
+    S::store(&b.p11[i], S::select(on, p11 - k10 * p01 - k11 * p11, p11));
+    S::store(&b.p12[i], S::select(on, p12 - k10 * p02 - k11 * p12, p12));
+    S::store(&b.p13[i], S::select(on, p13 - k10 * p03 - k11 * p13, p13));
+    S::store(&b.p22[i], S::select(on, p22 - k20 * p02 - k21 * p12, p22));
+    S::store(&b.p23[i], S::select(on, p23 - k20 * p03 - k21 * p13, p23));
+    S::store(&b.p33[i], S::select(on, p33 - k30 * p03 - k31 * p13, p33));
+}
+
+} // namespace
+
+void KalmanBank::resize(std::size_t count)
+{
+    n = count;
+    for (auto* v : {&x, &y, &vx, &vy,
+                    &p00, &p01, &p02, &p03, &p11, &p12, &p13, &p22, &p23, &p33})
+        v->assign(count, 0.0);
+}
+
+void KalmanBank::init(std::size_t i, double x0, double y0, double vx0, double vy0)
+{
+    x[i] = x0; y[i] = y0; vx[i] = vx0; vy[i] = vy0;
+
+    p00[i] = 10.0; p01[i] = 0.0; p02[i] = 0.0;   p03[i] = 0.0;
+                   p11[i] = 10.0; p12[i] = 0.0;  p13[i] = 0.0;
+                                  p22[i] = 100.0; p23[i] = 0.0;
+                                                  p33[i] = 100.0;
+}
+
+void KalmanBank::predict(const double* dt, const std::uint8_t* active)
+{
+    std::size_t i = 0;
+    for (; i + simd::Wide::width <= n; i += simd::Wide::width)
+        predict_lanes<simd::Wide>(*this, i, dt, active);
+    for (; i < n; ++i)
+        predict_lanes<simd::Scalar>(*this, i, dt, active);
+}
+
+void KalmanBank::predict_turn(const double* a, const double* b,
+                              const double* c, const double* s,
+                              const std::uint8_t* active)
+{
+    std::size_t i = 0;
+    for (; i + simd::Wide::width <= n; i += simd::Wide::width)
+        predict_turn_lanes<simd::Wide>(*this, i, a, b, c, s, active);
+    for (; i < n; ++i)
+        predict_turn_lanes<simd::Scalar>(*this, i, a, b, c, s, active);
+}
+
+void KalmanBank::update(const double* zx, const double* zy, const std::uint8_t* active,
+                        double* nis, double* det_s)
+{
+    std::size_t i = 0;
+    for (; i + simd::Wide::width <= n; i += simd::Wide::width)
+        update_lanes<simd::Wide>(*this, i, zx, zy, active, nis, det_s);
+    for (; i < n; ++i)
+        update_lanes<simd::Scalar>(*this, i, zx, zy, active, nis, det_s);
+}
+
+const char* kalman_bank_isa()
+{
+    return simd::isa_name();
+}
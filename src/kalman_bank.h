@@ -0,0 +1,54 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// N constant-velocity tracks in structure-of-arrays layout.
+//
+// Same model as KalmanFilter2D (state [x, y, vx, vy], position-only
+// measurement, R = r*I, Q = q*I) but F and H are folded into closed-form
+// expressions and only the upper triangle of the symmetric P is stored.
+// predict()/update() run across tracks with AVX-512 / AVX2 when the build
+// enables them (see simd.h) and a scalar loop otherwise.
+struct KalmanBank
+{
+    std::size_t n{0};
+
+    // state
+    std::vector<double> x, y, vx, vy;
+
+    // covariance, upper triangle
+    std::vector<double> p00, p01, p02, p03;
+    std::vector<double>      p11, p12, p13;
+    std::vector<double>           p22, p23;
+    std::vector<double>                p33;
+
+    double r{25.0};  // measurement noise variance per axis
+    double q{0.1};   // process noise variance per state
+
+    void resize(std::size_t count);
+
+    // Same initial state and covariance as KalmanFilter2D::init.
+    void init(std::size_t i, double x0, double y0, double vx0, double vy0);
+
+    // All arrays have n entries. Tracks whose `active` byte is 0 are left
+    // untouched; pass nullptr to step every track.
+    void predict(const double* dt, const std::uint8_t* active = nullptr);
+
+    // Predict with a known turn: F = [I A; 0 T], A = [a -b; b a],
+    // T = [c -s; s c] per track. With a = sin(w dt)/w, b = (1 - cos(w dt))/w,
+    // c = cos(w dt), s = sin(w dt) this is a coordinated turn at rate w;
+    // a = dt, b = s = 0, c = 1 reduces to predict().
+    void predict_turn(const double* a, const double* b,
+                      const double* c, const double* s,
+                      const std::uint8_t* active = nullptr);
+
+    // When given, nis[i] receives the normalized innovation squared
+    // e^T inv(S) e and det_s[i] the determinant of S (for the measurement
+    // likelihood); both are undefined for skipped tracks.
+    void update(const double* zx, const double* zy, const std::uint8_t* active = nullptr,
+                double* nis = nullptr, double* det_s = nullptr);
+};
+
+// Name of the instruction set the bank kernels were compiled for.
+const char* kalman_bank_isa();
@@ -1,19 +1,264 @@
 #include <iostream>
 #include <iomanip>
-#include <map>
 #include <vector>
 #include <string>
 #include <cstdlib>
+#include <fstream>
+#include <algorithm>
+#include <cstdio>
+#include <cerrno>
+#include <cmath>
 
-#include "kalman.h"
+#include "pipeline.h"
+#include "thread_pool.h"
+#include "track_file.h"
+#include "cpa_prob.h"
+#include "encounter.h"
+#include "associate.h"
+#include "scan.h"
+#include "replay.h"
+#include "smoother.h"
 #include "cpa.h"
 #include "io.h"
 #include "radar.h"
 #include "json_writer.h"
+#include "stream.h"
+#include "metrics.h"
+#include "udp_ingest.h"
+#include "instrument.h"
+
+// Per-scan risk timeline over the whole recording.
+static int run_scan_timeline(const TrackSeries& series,
+                             const Vec2& own_pos,
+                             const Vec2& own_vel,
+                             const ScanConfig& cfg,
+                             NdjsonWriter* ndjson,
+                             RadarRenderer* live_radar)
+{
+    ScanEngine engine(series, own_pos, own_vel, cfg);
+    ScanSnapshot snap;
+
+    // NDJSON on stdout replaces the table
+    const bool text = !ndjson || !ndjson->to_stdout();
+
+    std::size_t scans = 0;
+    std::size_t risky_scans = 0;
+    std::size_t max_risks = 0;
+
+    std::cout << std::fixed << std::setprecision(1);
+    if (text && !live_radar)
+    {
+        std::cout << "=== Risk timeline (all live tracks per scan) ===\n";
+        std::cout << std::left
+                  << std::setw(10) << "Time [s]"
+                  << std::setw(8)  << "Live"
+                  << std::setw(8)  << "Risks"
+                  << "Min CPA\n";
+        std::cout << std::string(10+8+8+20, '-') << "\n";
+    }
+
+    char caption[64];
+    while (engine.next(snap))
+    {
+        ++scans;
+        if (snap.risks) ++risky_scans;
+        max_risks = std::max(max_risks, snap.risks);
+
+        if (ndjson) ndjson->write_scan(snap, series.ids);
+
+        if (live_radar)
+        {
+            std::snprintf(caption, sizeof(caption), "t=%.1f s, %zu live, %zu at risk",
+                          snap.time, snap.live->size(), snap.risks);
+            live_radar->set_caption(caption);
+            live_radar->draw(snap.live->size(), snap.x, snap.y,
+                             snap.cpa->collision_risk.data(), own_pos);
+            live_radar->render_diff(std::cout);
+            continue;
+        }
+        if (!text) continue;
+
+        std::cout << std::left
+                  << std::setw(10) << snap.time
+                  << std::setw(8)  << snap.live->size()
+                  << std::setw(8)  << snap.risks;
+        if (snap.has_min_cpa)
+            std::cout << snap.min_cpa << " m (" << series.ids.name(snap.min_cpa_id) << ")";
+        else
+            std::cout << "-";
+        std::cout << "\n";
+    }
+
+    if (text)
+        std::cout << "\n" << scans << " scan(s), " << risky_scans
+                  << " with collision risk, at most " << max_risks << " at once\n";
+
+    if (ndjson) ndjson->flush();
+    return 0;
+}
+
+// Smoothed trajectory of every track: closest approach along it and the
+// stretch spent at collision risk.
+static int run_smoothing(const TrackSeries& series,
+                         ThreadPool& pool,
+                         const Vec2& own_pos,
+                         const Vec2& own_vel,
+                         const SmootherConfig& cfg,
+                         NdjsonWriter* ndjson)
+{
+    std::vector<SmoothedTrack> tracks;
+    smooth_tracks(series, pool, own_pos, own_vel, cfg, tracks);
+
+    if (ndjson && ndjson->to_stdout())
+    {
+        // records only, so that stdout stays parseable
+        for (TrackId id = 0; id < tracks.size(); ++id)
+            if (!tracks[id].points.empty()) ndjson->write_smoothed(series.ids.name(id), tracks[id]);
+        ndjson->flush();
+        return 0;
+    }
+
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "=== Smoothed CPA timeline (RTS, ";
+    if (cfg.lag == 0)
+        std::cout << "full batch";
+    else
+        std::cout << "fixed lag " << cfg.lag;
+    std::cout << ") ===\n";
+    std::cout << std::left
+              << std::setw(10) << "ID"
+              << std::setw(8)  << "Steps"
+              << std::setw(14) << "Min CPA [m]"
+              << std::setw(12) << "at t [s]"
+              << std::setw(12) << "Risk steps"
+              << "First risk [s]\n";
+    std::cout << std::string(10+8+14+12+12+14, '-') << "\n";
+
+    for (TrackId id = 0; id < tracks.size(); ++id)
+    {
+        const SmoothedTrack& t = tracks[id];
+        if (t.points.empty()) continue;
+
+        std::size_t best = t.points.size();
+        std::size_t risk_steps = 0;
+        std::size_t first_risk = t.points.size();
+        for (std::size_t k = 0; k < t.points.size(); ++k)
+        {
+            if (t.cpa.valid[k] && (best == t.points.size() ||
+                                   t.cpa.cpa_distance[k] < t.cpa.cpa_distance[best]))
+                best = k;
+            if (t.cpa.collision_risk[k])
+            {
+                ++risk_steps;
+                if (first_risk == t.points.size()) first_risk = k;
+            }
+        }
+
+        std::cout << std::left
+                  << std::setw(10) << series.ids.name(id)
+                  << std::setw(8)  << t.points.size();
+        if (best < t.points.size())
+            std::cout << std::setw(14) << t.cpa.cpa_distance[best]
+                      << std::setw(12) << t.points[best].time;
+        else
+            std::cout << std::setw(14) << "-" << std::setw(12) << "-";
+        std::cout << std::setw(12) << risk_steps;
+        if (first_risk < t.points.size())
+            std::cout << t.points[first_risk].time;
+        else
+            std::cout << "-";
+        std::cout << "\n";
+
+        if (ndjson) ndjson->write_smoothed(series.ids.name(id), t);
+    }
+
+    if (ndjson) ndjson->flush();
+    return 0;
+}
+
+// Whole-argument unsigned integer in [lo, hi]; rejects signs, spaces and
+// trailing characters, which strtoul would quietly accept or wrap.
+static bool parse_count(const char* s, std::size_t lo, std::size_t hi, std::size_t& out)
+{
+    if (*s < '0' || *s > '9') return false;
+    errno = 0;
+    char* end = nullptr;
+    unsigned long long v = std::strtoull(s, &end, 10);
+    if (errno == ERANGE || *end != '\0' || v < lo || v > hi) return false;
+    out = static_cast<std::size_t>(v);
+    return true;
+}
+
+// Whole-argument finite number; strtod alone would read "abc" as 0 and
+// ignore trailing characters.
+static bool parse_real(const char* s, double& out)
+{
+    errno = 0;
+    char* end = nullptr;
+    double v = std::strtod(s, &end);
+    if (end == s || *end != '\0' || errno == ERANGE || !std::isfinite(v)) return false;
+    out = v;
+    return true;
+}
 
 static void print_usage()
 {
-    std::cerr << "Usage: cpa_risk <csv_path> [--own-speed V] [--own-course DEG] [--json-out file]\n";
+    std::cerr << "Usage: cpa_risk <csv_path> [--own-speed V] [--own-course DEG] [--json-out file]\n"
+              << "                           [--ndjson-out file]\n"
+              << "                           [--stream [--follow] [--max-tracks N] [--track-timeout S]]\n"
+              << "                           [--metrics-port P]\n"
+              << "                           [--bank] [--imm] [--steady-gain]\n"
+              << "                           [--threads N] [--stats]\n"
+              << "                           [--pairs] [--scan [--scan-period S] [--radar-live]]\n"
+              << "                           [--replay X|max] [--smooth] [--smooth-lag L]\n"
+              << "                           [--radar-size N] [--radar-range M] [--radar-rings M]\n"
+              << "                           [--prob] [--prob-mc N] [--associate]\n"
+              << "       cpa_risk --udp PORT [--ais-origin LAT,LON] [--own-speed V] [--own-course DEG]\n"
+              << "                           [--ndjson-out file] [--max-tracks N] [--track-timeout S]\n"
+              << "                           [--metrics-port P]\n";
+    std::cerr << "\n--ndjson-out  write one JSON record per line: per track, or per update\n"
+              << "              with --stream ('-' = stdout)\n";
+    std::cerr << "--stream   process rows one at a time and print CPA/TCPA per update\n"
+              << "           (csv_path '-' reads from stdin)\n"
+              << "--follow   with --stream, keep waiting for rows appended to the file\n"
+              << "--max-tracks N     with --stream, live track slots (default 4096); when\n"
+              << "                   full the track with the oldest update is evicted\n"
+              << "--track-timeout S  with --stream, drop tracks without updates for S seconds\n"
+              << "                   (default 60)\n"
+              << "--udp PORT         stream NMEA sentences (TTM, AIS VDM types 1-3 / 18)\n"
+              << "                   received on UDP PORT instead of reading a CSV\n"
+              << "--ais-origin LAT,LON  with --udp, own ship's position; AIS reports are\n"
+              << "                   projected around it and ignored without it\n"
+              << "--metrics-port P   with --stream, serve Prometheus metrics on\n"
+              << "                   http://127.0.0.1:P/metrics (0 = any free port)\n"
+              << "--bank     filter all tracks together in a SIMD KalmanBank\n"
+              << "--imm      filter with an IMM (constant velocity + coordinated turns)\n"
+              << "--steady-gain  use the constant steady-state gain once a track's filter\n"
+              << "               has converged at a regular sample rate (not with\n"
+              << "               --bank or --imm)\n"
+              << "--threads N  load and filter tracks on N threads (0 = all cores, default 1)\n"
+              << "--stats    print per-stage latency (p50/p99/max) and throughput at exit\n"
+              << "--pairs    also screen target-to-target encounters\n"
+              << "--scan     replay all tracks in time order and print the CPA picture\n"
+              << "           of every scan (risk timeline)\n"
+              << "--scan-period S  group measurements into scans of S seconds (--scan,\n"
+              << "                 --replay, --associate)\n"
+              << "--smooth   smooth every track with an RTS smoother and print its CPA\n"
+              << "           timeline (--ndjson-out writes the smoothed steps)\n"
+              << "--smooth-lag L  fixed-lag smoothing with L steps of look-ahead\n"
+              << "--replay X       time the scan replay at X times real time (or max) and\n"
+              << "                 report rate, headroom, late scans and a result digest\n"
+              << "--radar-live     with --scan, redraw the radar in the terminal every scan\n"
+              << "                 (only changed cells are rewritten)\n"
+              << "--radar-size N   radar cells per side, odd, 3 to 401 (default 41)\n"
+              << "--radar-range M  radar range in metres (default: fit the farthest target)\n"
+              << "--radar-rings M  draw range rings every M metres\n"
+              << "--prob     add the collision probability from the filter covariance\n"
+              << "--prob-mc N  also print a Monte-Carlo estimate from N samples (validation)\n"
+              << "--associate  ignore the id column: assign the plots of each scan (timestamp,\n"
+              << "             or --scan-period window) to tracks by gated global nearest\n"
+              << "             neighbour (unlabeled plots)\n";
+    std::cerr << "\nThe input may also be a binary track file made by cpa_convert.\n";
     std::cerr << "\nCSV format (time series):\n"
               << "time,id,x,y,speed,course\n"
               << "0,1,100,50,5,180\n"
@@ -31,8 +276,32 @@ int main(int argc, char* argv[])
 
     std::string csv_path;
     std::string json_path;
+    std::string ndjson_path;
     double own_speed      = 20.0;  // defaults
     double own_course_deg = 30.0;  // defaults
+    bool stream_mode = false;
+    bool follow = false;
+    bool use_bank = false;
+    bool steady_gain = false;
+    bool use_imm = false;
+    bool with_prob = false;
+    std::size_t prob_mc_samples = 0;
+    unsigned num_threads = 1;
+    bool screen_pairs = false;
+    bool scan_mode = false;
+    bool replay_mode = false;
+    bool smooth_mode = false;
+    SmootherConfig smooth_cfg;
+    double replay_speed = 0.0;
+    double scan_period = 0.0;
+    bool associate = false;
+    StreamPoolConfig stream_pool;
+    RadarConfig radar_cfg;
+    bool radar_live = false;
+    bool show_stats = false;
+    int metrics_port = -1;
+    bool udp_mode = false;
+    UdpIngestConfig udp_cfg;
 
     // simple arg parser
     for (int i = 1; i < argc; ++i)
@@ -67,6 +336,256 @@ int main(int argc, char* argv[])
                 }
                 json_path = argv[++i];
             }
+            else if (arg == "--ndjson-out")
+            {
+                if (i + 1 >= argc)
+                {
+                    std::cerr << "--ndjson-out requires a file path\n";
+                    return 1;
+                }
+                ndjson_path = argv[++i];
+            }
+            else if (arg == "--stream")
+            {
+                stream_mode = true;
+            }
+            else if (arg == "--follow")
+            {
+                follow = true;
+            }
+            else if (arg == "--max-tracks")
+            {
+                if (i + 1 >= argc)
+                {
+                    std::cerr << "--max-tracks requires a value\n";
+                    return 1;
+                }
+                if (!parse_count(argv[++i], 1, 1u << 24, stream_pool.capacity))
+                {
+                    std::cerr << "--max-tracks must be between 1 and " << (1u << 24) << "\n";
+                    return 1;
+                }
+            }
+            else if (arg == "--track-timeout")
+            {
+                if (i + 1 >= argc)
+                {
+                    std::cerr << "--track-timeout requires a value\n";
+                    return 1;
+                }
+                if (!parse_real(argv[++i], stream_pool.timeout) || stream_pool.timeout <= 0.0)
+                {
+                    std::cerr << "--track-timeout must be a number of seconds > 0\n";
+                    return 1;
+                }
+            }
+            else if (arg == "--udp")
+            {
+                if (i + 1 >= argc)
+                {
+                    std::cerr << "--udp requires a port\n";
+                    return 1;
+                }
+                std::size_t port = 0;
+                if (!parse_count(argv[++i], 0, 65535, port))
+                {
+                    std::cerr << "--udp port must be between 0 and 65535\n";
+                    return 1;
+                }
+                udp_cfg.port = static_cast<std::uint16_t>(port);
+                udp_mode = true;
+                stream_mode = true;
+            }
+            else if (arg == "--ais-origin")
+            {
+                if (i + 1 >= argc)
+                {
+                    std::cerr << "--ais-origin requires LAT,LON\n";
+                    return 1;
+                }
+                const std::string v = argv[++i];
+                const std::size_t comma = v.find(',');
+                double lat = 0.0, lon = 0.0;
+                if (comma == std::string::npos ||
+                    !parse_real(v.substr(0, comma).c_str(), lat) ||
+                    !parse_real(v.c_str() + comma + 1, lon) ||
+                    std::fabs(lat) > 90.0 || std::fabs(lon) > 180.0)
+                {
+                    std::cerr << "--ais-origin expects LAT,LON in degrees (|LAT| <= 90, |LON| <= 180)\n";
+                    return 1;
+                }
+                udp_cfg.origin_lat = lat;
+                udp_cfg.origin_lon = lon;
+                udp_cfg.has_origin = true;
+            }
+            else if (arg == "--metrics-port")
+            {
+                if (i + 1 >= argc)
+                {
+                    std::cerr << "--metrics-port requires a value\n";
+                    return 1;
+                }
+                std::size_t port = 0;
+                if (!parse_count(argv[++i], 0, 65535, port))
+                {
+                    std::cerr << "--metrics-port must be between 0 and 65535\n";
+                    return 1;
+                }
+                metrics_port = static_cast<int>(port);
+            }
+            else if (arg == "--threads")
+            {
+                if (i + 1 >= argc)
+                {
+                    std::cerr << "--threads requires a value\n";
+                    return 1;
+                }
+                std::size_t n = 0;
+                if (!parse_count(argv[++i], 0, 1024, n))
+                {
+                    std::cerr << "--threads must be between 0 and 1024\n";
+                    return 1;
+                }
+                num_threads = static_cast<unsigned>(n);
+            }
+            else if (arg == "--scan")
+            {
+                scan_mode = true;
+            }
+            else if (arg == "--smooth")
+            {
+                smooth_mode = true;
+            }
+            else if (arg == "--smooth-lag")
+            {
+                if (i + 1 >= argc)
+                {
+                    std::cerr << "--smooth-lag requires a value\n";
+                    return 1;
+                }
+                if (!parse_count(argv[++i], 0, 100000, smooth_cfg.lag))
+                {
+                    std::cerr << "--smooth-lag must be between 0 and 100000\n";
+                    return 1;
+                }
+                smooth_mode = true;
+            }
+            else if (arg == "--replay")
+            {
+                if (i + 1 >= argc)
+                {
+                    std::cerr << "--replay requires a speed (e.g. 1, 10 or max)\n";
+                    return 1;
+                }
+                std::string v = argv[++i];
+                replay_speed = (v == "max") ? 0.0 : std::strtod(v.c_str(), nullptr);
+                if (v != "max" && !(replay_speed > 0.0))
+                {
+                    std::cerr << "--replay speed must be positive or max\n";
+                    return 1;
+                }
+                replay_mode = true;
+            }
+            else if (arg == "--scan-period")
+            {
+                if (i + 1 >= argc)
+                {
+                    std::cerr << "--scan-period requires a value\n";
+                    return 1;
+                }
+                if (!parse_real(argv[++i], scan_period) || scan_period < 0.0)
+                {
+                    std::cerr << "--scan-period must be a number of seconds >= 0\n";
+                    return 1;
+                }
+            }
+            else if (arg == "--stats")
+            {
+                show_stats = true;
+            }
+            else if (arg == "--radar-live")
+            {
+                radar_live = true;
+            }
+            else if (arg == "--radar-size")
+            {
+                if (i + 1 >= argc)
+                {
+                    std::cerr << "--radar-size requires a value\n";
+                    return 1;
+                }
+                std::size_t n = 0;
+                if (!parse_count(argv[++i], 3, 401, n) || n % 2 == 0)
+                {
+                    std::cerr << "--radar-size must be odd, between 3 and 401\n";
+                    return 1;
+                }
+                radar_cfg.size = static_cast<int>(n);
+            }
+            else if (arg == "--radar-range")
+            {
+                if (i + 1 >= argc)
+                {
+                    std::cerr << "--radar-range requires a value\n";
+                    return 1;
+                }
+                if (!parse_real(argv[++i], radar_cfg.range) || radar_cfg.range < 0.0)
+                {
+                    std::cerr << "--radar-range must be a number of metres >= 0\n";
+                    return 1;
+                }
+            }
+            else if (arg == "--radar-rings")
+            {
+                if (i + 1 >= argc)
+                {
+                    std::cerr << "--radar-rings requires a value\n";
+                    return 1;
+                }
+                if (!parse_real(argv[++i], radar_cfg.ring_spacing) || radar_cfg.ring_spacing < 0.0)
+                {
+                    std::cerr << "--radar-rings must be a number of metres >= 0\n";
+                    return 1;
+                }
+            }
+            else if (arg == "--pairs")
+            {
+                screen_pairs = true;
+            }
+            else if (arg == "--bank")
+            {
+                use_bank = true;
+            }
+            else if (arg == "--prob")
+            {
+                with_prob = true;
+            }
+            else if (arg == "--prob-mc")
+            {
+                if (i + 1 >= argc)
+                {
+                    std::cerr << "--prob-mc requires a value\n";
+                    return 1;
+                }
+                if (!parse_count(argv[++i], 1, 1000000000, prob_mc_samples))
+                {
+                    std::cerr << "--prob-mc must be between 1 and 1000000000\n";
+                    return 1;
+                }
+                with_prob = true;
+            }
+            else if (arg == "--imm")
+            {
+                use_imm = true;
+            }
+            else if (arg == "--steady-gain")
+            {
+                steady_gain = true;
+            }
+            else if (arg == "--associate")
+            {
+                associate = true;
+            }
             else
             {
                 std::cerr << "Unknown option: " << arg << "\n";
@@ -87,18 +606,185 @@ int main(int argc, char* argv[])
         }
     }
 
-    if (csv_path.empty())
+    if (csv_path.empty() && !udp_mode)
     {
         std::cerr << "CSV path is required.\n";
         print_usage();
         return 1;
     }
 
-    // time-series: id -> vector<Measurement>
-    std::map<std::string, std::vector<Measurement>> series;
-    if (!load_timeseries_from_csv(csv_path, series))
+    if (udp_mode && !csv_path.empty())
+    {
+        std::cerr << "--udp reads from the network; drop the CSV path\n";
+        return 1;
+    }
+
+    if (udp_cfg.has_origin && !udp_mode)
+    {
+        std::cerr << "--ais-origin requires --udp\n";
+        return 1;
+    }
+
+    if (follow && !stream_mode)
+    {
+        std::cerr << "--follow requires --stream\n";
+        return 1;
+    }
+
+    if (metrics_port >= 0 && !stream_mode)
+    {
+        std::cerr << "--metrics-port requires --stream\n";
+        return 1;
+    }
+
+    if (steady_gain && (use_bank || use_imm))
+    {
+        std::cerr << "--steady-gain applies to the per-track filter; drop --bank / --imm\n";
+        return 1;
+    }
+
+    if (radar_live && !scan_mode)
+    {
+        std::cerr << "--radar-live requires --scan\n";
+        return 1;
+    }
+
+    if (radar_live && ndjson_path == "-")
+    {
+        std::cerr << "--radar-live draws on stdout; write --ndjson-out to a file\n";
+        return 1;
+    }
+
+    // the scrape reports per-stage latency too
+    if (show_stats || metrics_port >= 0)
+    {
+        if (CPA_INSTRUMENT)
+            instr::set_enabled(true);
+        else if (show_stats)
+            std::cerr << "--stats: built without instrumentation (CPA_INSTRUMENT=OFF)\n";
+    }
+    auto finish = [&](int rc)
+    {
+        if (show_stats) instr::report(std::cerr);
+        return rc;
+    };
+
+    NdjsonWriter ndjson;
+    if (!ndjson_path.empty() && !ndjson.open(ndjson_path))
+        return 1;
+    NdjsonWriter* ndjson_out = ndjson.is_open() ? &ndjson : nullptr;
+    // with NDJSON on stdout the tables and the radar are left out, and
+    // messages that remain go to stderr
+    const bool text_out = !ndjson.to_stdout();
+    std::ostream& info = text_out ? std::cout : std::cerr;
+
+    if (stream_mode)
+    {
+        Vec2 own_pos{0.0, 0.0};
+        Vec2 own_vel = course_to_velocity(own_speed, own_course_deg);
+
+        MetricsServer metrics;
+        MetricsServer* metrics_out = nullptr;
+        if (metrics_port >= 0)
+        {
+            if (!metrics.start(static_cast<std::uint16_t>(metrics_port)))
+                return 1;
+            std::cerr << "metrics: http://127.0.0.1:" << metrics.port() << "/metrics\n";
+            metrics_out = &metrics;
+        }
+
+        if (udp_mode)
+        {
+            UdpReceiver rx(udp_cfg);
+            if (!rx.start())
+                return 1;
+            std::cerr << "udp: listening on port " << rx.port() << "\n";
+            if (!udp_cfg.has_origin)
+                std::cerr << "udp: no --ais-origin, AIS reports will be ignored\n";
+            return finish(run_udp_stream(rx, own_pos, own_vel, ndjson_out, stream_pool, metrics_out));
+        }
+
+        if (csv_path == "-")
+            return finish(run_stream(std::cin, own_pos, own_vel, follow, ndjson_out, stream_pool,
+                                     metrics_out));
+
+        if (is_track_file(csv_path))
+        {
+            if (follow)
+            {
+                std::cerr << "--follow needs a CSV; track files are complete recordings\n";
+                return 1;
+            }
+            TrackFile track_file;
+            if (!track_file.open(csv_path))
+                return 1;
+            return finish(run_stream(track_file, own_pos, own_vel, ndjson_out, stream_pool,
+                                     metrics_out));
+        }
+
+        std::ifstream file(csv_path);
+        if (!file)
+        {
+            std::cerr << "Failed to open file: " << csv_path << "\n";
+            return 1;
+        }
+        return finish(run_stream(file, own_pos, own_vel, follow, ndjson_out, stream_pool,
+                                 metrics_out));
+    }
+
+    // time-series: TrackId -> vector<Measurement>
+    ThreadPool pool(num_threads);
+
+    TrackSeries series;
+    // A track file is filtered straight from its mapped columns when only
+    // the final picture is asked for; series then carries just the ids, one
+    // empty row vector per block.
+    TrackFile track_file;
+    bool direct = false;
+    bool loaded = true;
+    {
+        CPA_TIMER(timer, Load);
+        const bool binary = is_track_file(csv_path);
+        if (binary && !(associate || smooth_mode || replay_mode || scan_mode || use_bank ||
+                        use_imm || ndjson_out || !json_path.empty()))
+        {
+            loaded = track_file.open(csv_path);
+            direct = loaded && track_file_ids(track_file, series.ids);
+            if (direct)
+                series.series.resize(track_file.num_tracks());
+            CPA_SET_ITEMS(timer, track_file.num_rows());
+        }
+        if (loaded && !direct)
+        {
+            series = TrackSeries{};
+            loaded = binary               ? load_track_file(csv_path, series)
+                   : (pool.size() > 1)    ? load_timeseries_from_csv_parallel(csv_path, series, pool)
+                                          : load_timeseries_from_csv(csv_path, series);
+            CPA_SET_ITEMS(timer, series.num_rows());
+        }
+    }
+    if (!loaded)
         return 1;
 
+    if (associate)
+    {
+        TrackSeries plots = std::move(series);
+        AssociationStats ast;
+        {
+            CPA_TIMED_SCOPE_N(Associate, plots.num_rows());
+            AssociationConfig acfg;
+            acfg.scan_period = scan_period;
+            associate_series(plots, series, acfg, &ast);
+        }
+        info << "Associated " << ast.plots << " plot(s) in " << ast.scans
+                  << " scan(s): " << series.size() << " confirmed track(s), "
+                  << ast.spawned << " spawned, " << ast.deleted << " deleted, "
+                  << ast.gated_pairs << " gated pair(s)\n\n";
+        if (series.empty() && scan_period <= 0.0 && ast.scans > 1)
+            std::cerr << "No track was confirmed. If the plots of one sweep have different"
+                         " timestamps, group them with --scan-period.\n";
+    }
+
     if (series.empty())
     {
         std::cerr << "No data loaded.\n";
@@ -108,88 +794,198 @@ int main(int argc, char* argv[])
     Vec2 own_pos{0.0, 0.0};
     Vec2 own_vel = course_to_velocity(own_speed, own_course_deg);
 
-    // run filter for each ID
-    std::map<std::string, CpaResult> final_results;
-    std::map<std::string, Vec2> final_positions;
-    std::map<std::string, Vec2> final_velocities;
-    std::vector<std::pair<std::string, Vec2>> radar_positions;
+    if (smooth_mode)
+        return finish(run_smoothing(series, pool, own_pos, own_vel, smooth_cfg, ndjson_out));
 
-    for (const auto& kv : series)
+    if (replay_mode)
     {
-        const std::string& id = kv.first;
-        const auto& seq = kv.second;
-        if (seq.empty()) continue;
-
-        KalmanFilter2D kf;
-        Vec2 v0 = course_to_velocity(seq.front().speed, seq.front().course_deg);
-        kf.init(seq.front().x, seq.front().y, v0.x, v0.y);
+        ReplayConfig cfg;
+        cfg.speed = replay_speed;
+        cfg.scan.period = scan_period;
+        ReplayReport report = run_replay(series, own_pos, own_vel, cfg, ndjson_out);
+        print_replay_report(report, info);
+        return finish(0);
+    }
 
-        double prev_time = seq.front().time;
+    if (scan_mode)
+    {
+        ScanConfig cfg;
+        cfg.period = scan_period;
+        if (radar_live)
+        {
+            RadarRenderer radar(radar_cfg);
+            return finish(run_scan_timeline(series, own_pos, own_vel, cfg, ndjson_out, &radar));
+        }
+        return finish(run_scan_timeline(series, own_pos, own_vel, cfg, ndjson_out, nullptr));
+    }
 
-        for (std::size_t i = 0; i < seq.size(); ++i)
+    // run filter for each ID; one preallocated slot per track, gathered
+    // without locks
+    std::vector<TrackState> states;
+    {
+        CPA_TIMED_SCOPE_N(Filter, series.size());
+        if (use_imm)
+        {
+            filter_tracks_imm(series, states);
+        }
+        else if (use_bank)
+        {
+            filter_tracks_bank(series, states);
+        }
+        else if (direct)
         {
-            double t   = seq[i].time;
-            double dt  = t - prev_time;
-            if (dt < 0) dt = 0.0;
+            filter_tracks(track_file, pool, states, steady_gain);
+        }
+        else
+        {
+            filter_tracks(series, pool, states, steady_gain);
+        }
+    }
 
-            kf.predict(dt);
-            kf.update(seq[i].x, seq[i].y);
+    // filtered final states, also in SoA form for the batch CPA kernel
+    const std::size_t n = series.size();
+    std::vector<Vec2> final_positions(n);
+    std::vector<Vec2> final_velocities(n);
+    std::vector<double> tgt_x(n), tgt_y(n), tgt_vx(n), tgt_vy(n);
+    for (TrackId id = 0; id < n; ++id)
+    {
+        const TrackState& st = states[id];
 
-            prev_time = t;
-        }
+        final_positions[id] = st.pos;
+        final_velocities[id]= st.vel;
 
-        Vec2 filt_pos{kf.getX(),  kf.getY()};
-        Vec2 filt_vel{kf.getVx(), kf.getVy()};
+        tgt_x[id]  = st.pos.x;
+        tgt_y[id]  = st.pos.y;
+        tgt_vx[id] = st.vel.x;
+        tgt_vy[id] = st.vel.y;
+    }
+
+    // CPA for all targets in one pass
+    CpaResultBlock cpa_block;
+    {
+        CPA_TIMED_SCOPE_N(Cpa, n);
+        compute_cpa_batch(own_pos, own_vel,
+                          tgt_x.data(), tgt_y.data(), tgt_vx.data(), tgt_vy.data(),
+                          n, cpa_block);
+    }
 
-        CpaResult res = compute_cpa(own_pos, own_vel, filt_pos, filt_vel);
+    std::vector<CpaResult> final_results(n);
+    for (TrackId id = 0; id < n; ++id)
+        final_results[id] = cpa_block.at(id);
 
-        final_results[id]   = res;
-        final_positions[id] = filt_pos;
-        final_velocities[id]= filt_vel;
+    // collision probability from the filter covariance
+    std::vector<double> p_collision, p_collision_mc;
+    if (with_prob)
+    {
+        CPA_TIMED_SCOPE_N(Probability, n);
+        p_collision.resize(n);
+        for (TrackId id = 0; id < n; ++id)
+            p_collision[id] = collision_probability(own_pos, own_vel,
+                                                    states[id].pos, states[id].vel,
+                                                    states[id].cov);
+    }
 
-        radar_positions.push_back({id, filt_pos});
+    // records go out before the tables and the radar are drawn
+    if (ndjson_out)
+    {
+        CPA_TIMED_SCOPE_N(Ndjson, n);
+        for (TrackId id = 0; id < n; ++id)
+            ndjson_out->write_track(series.ids.name(id), series.series[id],
+                                    final_positions[id], final_velocities[id],
+                                    final_results[id],
+                                    with_prob ? &p_collision[id] : nullptr);
+        ndjson_out->flush();
     }
 
-    std::cout << std::fixed << std::setprecision(1);
-    std::cout << "=== CPA / TCPA Results (Kalman, final state per id) ===\n";
-    std::cout << std::left
-              << std::setw(8)  << "ID"
-              << std::setw(12) << "CPA [m]"
-              << std::setw(12) << "TCPA [s]"
-              << "Status\n";
-    std::cout << std::string(8+12+12+12, '-') << "\n";
+    if (prob_mc_samples && text_out)
+    {
+        p_collision_mc.resize(n);
+        for (TrackId id = 0; id < n; ++id)
+            p_collision_mc[id] = collision_probability_mc(own_pos, own_vel,
+                                                          states[id].pos, states[id].vel,
+                                                          states[id].cov, prob_mc_samples,
+                                                          id + 1);
+    }
 
-    for (const auto& kv : series)
+    if (text_out)
     {
-        const std::string& id = kv.first;
-        const auto& r = final_results[id];
+        CPA_TIMED_SCOPE_N(Table, n);
+        std::cout << std::fixed << std::setprecision(1);
+        std::cout << "=== CPA / TCPA Results (Kalman, final state per id) ===\n";
+        std::cout << std::left
+                  << std::setw(8)  << "ID"
+                  << std::setw(12) << "CPA [m]"
+                  << std::setw(12) << "TCPA [s]";
+        if (with_prob)        std::cout << std::setw(10) << "P(coll)";
+        if (prob_mc_samples)  std::cout << std::setw(10) << "P(MC)";
+        std::cout << "Status\n";
+        std::cout << std::string(8+12+12+12 + (with_prob ? 10 : 0) + (prob_mc_samples ? 10 : 0), '-') << "\n";
 
-        std::string status;
-        if (!r.valid)              status = "No relative motion";
-        else if (!r.closing)       status = "Diverging";
-        else if (r.collision_risk) status = "COLLISION RISK";
-        else                       status = "Safe";
+        for (TrackId id = 0; id < n; ++id)
+        {
+            const auto& r = final_results[id];
 
+            std::cout << std::left
+                      << std::setw(8)  << series.ids.name(id)
+                      << std::setw(12) << r.cpa_distance
+                      << std::setw(12) << r.tcpa;
+            std::cout << std::setprecision(4);
+            if (with_prob)        std::cout << std::setw(10) << p_collision[id];
+            if (prob_mc_samples)  std::cout << std::setw(10) << p_collision_mc[id];
+            std::cout << std::setprecision(1);
+            std::cout << cpa_status_text(r) << "\n";
+        }
+        std::cout << "\n";
+    }
+
+    if (screen_pairs && text_out)
+    {
+        CPA_TIMED_SCOPE_N(Pairs, n);
+        std::vector<EncounterPair> pairs;
+        EncounterStats est;
+        screen_encounters_grid(final_positions, final_velocities, pairs, &est);
+
+        std::cout << "=== Target-to-target encounters ===\n";
         std::cout << std::left
-                  << std::setw(8)  << id
-                  << std::setw(12) << r.cpa_distance
-                  << std::setw(12) << r.tcpa
-                  << status << "\n";
+                  << std::setw(8)  << "ID A"
+                  << std::setw(8)  << "ID B"
+                  << std::setw(12) << "CPA [m]"
+                  << "TCPA [s]\n";
+        std::cout << std::string(8+8+12+12, '-') << "\n";
+        for (const auto& p : pairs)
+        {
+            std::cout << std::left
+                      << std::setw(8)  << series.ids.name(p.a)
+                      << std::setw(8)  << series.ids.name(p.b)
+                      << std::setw(12) << p.cpa.cpa_distance
+                      << p.cpa.tcpa << "\n";
+        }
+        std::cout << pairs.size() << " encounter(s), "
+                  << est.candidate_pairs << " candidate pair(s) checked\n\n";
     }
-    std::cout << "\n";
 
-    print_ascii_radar(radar_positions, final_results, own_pos);
+    if (text_out)
+    {
+        CPA_TIMED_SCOPE_N(Radar, n);
+        RadarRenderer radar(radar_cfg);
+        radar.draw(final_positions, final_results, own_pos);
+        radar.render(std::cout);
+    }
 
     if (!json_path.empty())
     {
-        write_json(json_path,
-                   series,
-                   final_results,
-                   final_positions,
-                   final_velocities,
-                   own_pos,
-                   own_vel);
+        CPA_TIMED_SCOPE_N(Json, n);
+        if (!write_json(json_path,
+                        series,
+                        final_results,
+                        final_positions,
+                        final_velocities,
+                        own_pos,
+                        own_vel,
+                        with_prob ? &p_collision : nullptr))
+            return finish(1);
+        info << "JSON saved to " << json_path << "\n";
     }
 
-    return 0;
+    return finish(0);
 }
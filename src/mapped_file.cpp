@@ -0,0 +1,112 @@
+#include "mapped_file.h"
+
+#include <cerrno>
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define CPA_HAVE_MMAP 1
+#endif
+
+#ifdef CPA_HAVE_MMAP
+bool MappedFile::read_all(int fd)
+{
+    std::size_t len = 0;
+    buffer_.resize(1 << 16);
+    for (;;)
+    {
+        if (len == buffer_.size()) buffer_.resize(buffer_.size() * 2);
+        ssize_t n = ::read(fd, buffer_.data() + len, buffer_.size() - len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0)
+        {
+            buffer_.clear();
+            return false;
+        }
+        if (n == 0) break;
+        len += static_cast<std::size_t>(n);
+    }
+    buffer_.resize(len);
+
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+    return true;
+}
+#endif
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+bool MappedFile::open(const std::string& path)
+{
+    close();
+
+#ifdef CPA_HAVE_MMAP
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    if (!S_ISREG(st.st_mode))
+    {
+        // pipes, character devices (/dev/stdin): read them to the end
+        bool ok = read_all(fd);
+        ::close(fd);
+        return ok;
+    }
+
+    size_ = static_cast<std::size_t>(st.st_size);
+    if (size_ == 0)
+    {
+        ::close(fd);
+        return true;
+    }
+
+    void* p = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED)
+    {
+        size_ = 0;
+        return false;
+    }
+    ::madvise(p, size_, MADV_SEQUENTIAL);
+
+    data_ = static_cast<const char*>(p);
+    mapped_ = true;
+    return true;
+#else
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) return false;
+
+    std::streamsize len = file.tellg();
+    file.seekg(0);
+    buffer_.resize(static_cast<std::size_t>(len));
+    if (len > 0 && !file.read(buffer_.data(), len)) return false;
+
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+    return true;
+#endif
+}
+
+void MappedFile::close()
+{
+#ifdef CPA_HAVE_MMAP
+    if (mapped_)
+        ::munmap(const_cast<char*>(data_), size_);
+#endif
+    mapped_ = false;
+    data_ = nullptr;
+    size_ = 0;
+    buffer_.clear();
+}
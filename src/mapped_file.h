@@ -0,0 +1,33 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Read-only view of a whole file. Regular files are memory-mapped on POSIX;
+// pipes and character devices (/dev/stdin), and every file elsewhere, are
+// read into an owned buffer. An empty file opens with size() == 0.
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+
+    const char* data() const { return data_; }
+    std::size_t size() const { return size_; }
+    std::string_view view() const { return std::string_view(data_, size_); }
+
+private:
+    bool read_all(int fd);
+
+    const char* data_{nullptr};
+    std::size_t size_{0};
+    bool mapped_{false};
+    std::vector<char> buffer_;
+};
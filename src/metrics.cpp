@@ -0,0 +1,254 @@
+#include "metrics.h"
+#include "instrument.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#define CPA_HAVE_SOCKETS 1
+#endif
+
+namespace
+{
+
+void append_metric(std::string& out, const char* name, const char* type,
+                   const char* help, double value)
+{
+    char buf[256];
+    std::snprintf(buf, sizeof(buf), "# HELP %s %s\n# TYPE %s %s\n%s %.17g\n",
+                  name, help, name, type, name, value);
+    out += buf;
+}
+
+void append_stages(std::string& out)
+{
+    bool any = false;
+    char buf[256];
+    for (std::size_t s = 0; s < static_cast<std::size_t>(instr::Stage::Count); ++s)
+    {
+        instr::StageSummary sum;
+        if (!instr::summarize(static_cast<instr::Stage>(s), sum)) continue;
+        if (!any)
+        {
+            out += "# HELP cpa_stage_latency_seconds Latency per call of each pipeline stage.\n"
+                   "# TYPE cpa_stage_latency_seconds summary\n";
+            any = true;
+        }
+        const char* name = instr::stage_name(static_cast<instr::Stage>(s));
+        std::snprintf(buf, sizeof(buf),
+                      "cpa_stage_latency_seconds{stage=\"%s\",quantile=\"0.5\"} %.9f\n"
+                      "cpa_stage_latency_seconds{stage=\"%s\",quantile=\"0.99\"} %.9f\n"
+                      "cpa_stage_latency_seconds_sum{stage=\"%s\"} %.9f\n"
+                      "cpa_stage_latency_seconds_count{stage=\"%s\"} %llu\n",
+                      name, static_cast<double>(sum.p50_ns) * 1e-9,
+                      name, static_cast<double>(sum.p99_ns) * 1e-9,
+                      name, static_cast<double>(sum.total_ns) * 1e-9,
+                      name, static_cast<unsigned long long>(sum.calls));
+        out += buf;
+    }
+}
+
+} // namespace
+
+std::string format_metrics(const MetricsSnapshot& s, double uptime_s)
+{
+    std::string out;
+    out.reserve(4096);
+
+    append_metric(out, "cpa_uptime_seconds", "gauge", "Seconds since the service started.", uptime_s);
+    append_metric(out, "cpa_updates_total", "counter", "Measurements applied to a track.",
+                  static_cast<double>(s.updates));
+    append_metric(out, "cpa_rejected_lines_total", "counter", "Malformed input rows.",
+                  static_cast<double>(s.rejected_lines));
+    append_metric(out, "cpa_late_total", "counter", "Out-of-order rows slotted in by a replay.",
+                  static_cast<double>(s.late));
+    append_metric(out, "cpa_too_late_total", "counter", "Rows older than the replay window, dropped.",
+                  static_cast<double>(s.too_late));
+    append_metric(out, "cpa_replayed_total", "counter", "Updates re-applied after late rows.",
+                  static_cast<double>(s.replayed));
+    append_metric(out, "cpa_risk_alerts_total", "counter", "Times a track entered collision risk.",
+                  static_cast<double>(s.alerts));
+
+    append_metric(out, "cpa_live_tracks", "gauge", "Tracks currently held.",
+                  static_cast<double>(s.live_tracks));
+    append_metric(out, "cpa_track_capacity", "gauge", "Track pool capacity.",
+                  static_cast<double>(s.capacity));
+    append_metric(out, "cpa_tracks_created_total", "counter", "Tracks started.",
+                  static_cast<double>(s.created));
+    append_metric(out, "cpa_tracks_expired_total", "counter", "Tracks dropped after the timeout.",
+                  static_cast<double>(s.expired));
+    append_metric(out, "cpa_tracks_evicted_total", "counter", "Tracks dropped because the pool was full.",
+                  static_cast<double>(s.evicted));
+
+    append_metric(out, "cpa_tracks_collision_risk", "gauge", "Live tracks with collision_risk set.",
+                  static_cast<double>(s.risk));
+    append_metric(out, "cpa_tracks_closing", "gauge", "Live tracks with closing set.",
+                  static_cast<double>(s.closing));
+    append_metric(out, "cpa_tracks_valid", "gauge", "Live tracks with a valid CPA.",
+                  static_cast<double>(s.valid));
+
+    append_metric(out, "cpa_queue_depth", "gauge", "Rows received but not yet applied.",
+                  static_cast<double>(s.queue_depth));
+    append_metric(out, "cpa_update_latency_mean_seconds", "gauge", "Mean filter + CPA time per row.",
+                  s.latency_mean_us * 1e-6);
+    append_metric(out, "cpa_update_latency_max_seconds", "gauge", "Max filter + CPA time per row.",
+                  s.latency_max_us * 1e-6);
+    append_metric(out, "cpa_last_measurement_time_seconds", "gauge", "Track time of the latest row.",
+                  s.last_time);
+
+    append_stages(out);
+    return out;
+}
+
+MetricsServer::MetricsServer() = default;
+
+MetricsServer::~MetricsServer()
+{
+    stop();
+}
+
+#ifdef CPA_HAVE_SOCKETS
+
+bool MetricsServer::start(std::uint16_t port)
+{
+    fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (fd_ < 0)
+    {
+        std::cerr << "metrics: socket: " << std::strerror(errno) << "\n";
+        return false;
+    }
+    int one = 1;
+    ::setsockopt(fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    if (::bind(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        ::listen(fd_, 8) != 0)
+    {
+        std::cerr << "metrics: cannot listen on 127.0.0.1:" << port << ": "
+                  << std::strerror(errno) << "\n";
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+
+    socklen_t len = sizeof(addr);
+    ::getsockname(fd_, reinterpret_cast<sockaddr*>(&addr), &len);
+    port_ = ntohs(addr.sin_port);
+
+    started_ = std::chrono::steady_clock::now();
+    stop_ = false;
+    thread_ = std::thread(&MetricsServer::serve, this);
+    return true;
+}
+
+void MetricsServer::stop()
+{
+    stop_ = true;
+    if (thread_.joinable()) thread_.join();
+    if (fd_ >= 0)
+    {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+void MetricsServer::serve()
+{
+    while (!stop_)
+    {
+        pollfd p{ fd_, POLLIN, 0 };
+        if (::poll(&p, 1, 200) <= 0) continue;  // wake up to check stop_
+
+        int client = ::accept(fd_, nullptr, nullptr);
+        if (client < 0) continue;
+        answer(client);
+        ::close(client);
+    }
+}
+
+void MetricsServer::answer(int client)
+{
+    // the request line is all we need; give a slow client one second
+    char req[2048];
+    std::size_t got = 0;
+    while (got < sizeof(req) - 1)
+    {
+        pollfd p{ client, POLLIN, 0 };
+        if (::poll(&p, 1, 1000) <= 0) return;
+        ssize_t n = ::recv(client, req + got, sizeof(req) - 1 - got, 0);
+        if (n <= 0) return;
+        got += static_cast<std::size_t>(n);
+        req[got] = '\0';
+        if (std::strstr(req, "\r\n\r\n") || std::strstr(req, "\n\n")) break;
+    }
+    req[got] = '\0';
+
+    std::string body;
+    const char* status;
+    if (std::strncmp(req, "GET /metrics ", 13) == 0 || std::strncmp(req, "GET /metrics?", 13) == 0)
+    {
+        double uptime = std::chrono::duration<double>(std::chrono::steady_clock::now() - started_).count();
+        body = format_metrics(buf_.read(), uptime);
+        status = "200 OK";
+    }
+    else
+    {
+        body = "not found; try /metrics\n";
+        status = "404 Not Found";
+    }
+
+    char head[160];
+    int hn = std::snprintf(head, sizeof(head),
+                           "HTTP/1.1 %s\r\n"
+                           "Content-Type: text/plain; version=0.0.4\r\n"
+                           "Content-Length: %zu\r\n"
+                           "Connection: close\r\n\r\n",
+                           status, body.size());
+    std::string resp(head, static_cast<std::size_t>(hn));
+    resp += body;
+
+#ifdef MSG_NOSIGNAL
+    const int flags = MSG_NOSIGNAL;
+#else
+    const int flags = 0;
+#endif
+    std::size_t sent = 0;
+    while (sent < resp.size())
+    {
+        ssize_t n = ::send(client, resp.data() + sent, resp.size() - sent, flags);
+        if (n <= 0) return;
+        sent += static_cast<std::size_t>(n);
+    }
+}
+
+#else
+
+bool MetricsServer::start(std::uint16_t)
+{
+    std::cerr << "metrics: not supported on this platform\n";
+    return false;
+}
+
+void MetricsServer::stop()
+{
+}
+
+void MetricsServer::serve()
+{
+}
+
+void MetricsServer::answer(int)
+{
+}
+
+#endif
@@ -0,0 +1,110 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+// Lock-free single-writer / single-reader hand-off of the latest value.
+// The writer fills back() and publishes it; the reader gets the most
+// recently published value. Neither side ever waits.
+template <class T>
+class TripleBuffer
+{
+public:
+    T& back() { return slots_[back_]; }
+
+    void publish()
+    {
+        back_ = middle_.exchange(back_ | FRESH, std::memory_order_acq_rel) & INDEX;
+    }
+
+    // Reader only; the previous value again if nothing new was published.
+    const T& read()
+    {
+        if (middle_.load(std::memory_order_relaxed) & FRESH)
+            front_ = middle_.exchange(front_, std::memory_order_acq_rel) & INDEX;
+        return slots_[front_];
+    }
+
+private:
+    static constexpr unsigned INDEX = 3;
+    static constexpr unsigned FRESH = 4;
+
+    T slots_[3]{};
+    unsigned back_{0};
+    unsigned front_{1};
+    std::atomic<unsigned> middle_{2};
+};
+
+// State of the tracking loop as seen by a scrape.
+struct MetricsSnapshot
+{
+    std::uint64_t updates{0};         // rows applied to a track
+    std::uint64_t rejected_lines{0};
+    std::uint64_t late{0};
+    std::uint64_t too_late{0};
+    std::uint64_t replayed{0};
+    std::uint64_t alerts{0};          // tracks entering collision risk
+
+    std::uint64_t live_tracks{0};
+    std::uint64_t capacity{0};
+    std::uint64_t created{0};
+    std::uint64_t expired{0};
+    std::uint64_t evicted{0};
+
+    // live tracks by CpaResult flag
+    std::uint64_t risk{0};
+    std::uint64_t closing{0};
+    std::uint64_t valid{0};
+
+    // rows received but not yet applied (ingest queue); 0 when the tracker
+    // reads its input directly
+    std::uint64_t queue_depth{0};
+
+    double latency_mean_us{0.0};
+    double latency_max_us{0.0};
+    double last_time{0.0};            // track time of the latest row
+};
+
+// Prometheus text exposition of a snapshot plus the per-stage latency
+// summaries of the instrumentation layer (see instrument.h).
+std::string format_metrics(const MetricsSnapshot& s, double uptime_s);
+
+// Minimal HTTP server for GET /metrics on the loopback interface.
+//
+// The tracking loop calls publish() (wait-free) whenever it has a new
+// snapshot; a background thread accepts one connection at a time and
+// answers from the latest published snapshot, so a scrape never stalls
+// the loop. POSIX sockets only; start() fails elsewhere.
+class MetricsServer
+{
+public:
+    MetricsServer();
+    ~MetricsServer();
+
+    MetricsServer(const MetricsServer&) = delete;
+    MetricsServer& operator=(const MetricsServer&) = delete;
+
+    // Listen on 127.0.0.1:port (0 picks a free port); false on error.
+    bool start(std::uint16_t port);
+    void stop();
+
+    std::uint16_t port() const { return port_; }
+
+    // Writer side: fill snapshot() and publish it.
+    MetricsSnapshot& snapshot() { return buf_.back(); }
+    void publish() { buf_.publish(); }
+
+private:
+    void serve();
+    void answer(int client);
+
+    TripleBuffer<MetricsSnapshot> buf_;
+    std::thread thread_;
+    std::atomic<bool> stop_{false};
+    int fd_{-1};
+    std::uint16_t port_{0};
+    std::chrono::steady_clock::time_point started_;
+};
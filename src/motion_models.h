@@ -0,0 +1,136 @@
+#pragma once
+#include <cmath>
+
+// Motion models for KalmanFilter<Model>.
+//
+// Each model fixes the state dimension N at compile time, the sparsity of
+// its transition matrix (F_nz), how the state moves over dt (propagate) and
+// the transition Jacobian (transition, which only has to fill the F_nz
+// entries). The first four states are always [x, y, vx, vy] and only the
+// position is measured.
+
+// Constant velocity: [x, y, vx, vy]
+struct ConstantVelocity
+{
+    static constexpr int N = 4;
+    static constexpr bool linear = true;
+
+    static constexpr bool F_nz(int i, int j)
+    {
+        return i == j || (i < 2 && j == i + 2);
+    }
+
+    static void propagate(double* s, double dt)
+    {
+        s[0] += dt * s[2];
+        s[1] += dt * s[3];
+    }
+
+    static void transition(const double* /*s*/, double dt, double F[N][N])
+    {
+        for (int i = 0; i < N; ++i) F[i][i] = 1.0;
+        F[0][2] = dt;
+        F[1][3] = dt;
+    }
+
+    static double initial_var(int i) { return i < 2 ? 10.0 : 100.0; }
+    static double process_var(int /*i*/) { return 0.1; }
+};
+
+// Constant acceleration: [x, y, vx, vy, ax, ay]
+struct ConstantAcceleration
+{
+    static constexpr int N = 6;
+    static constexpr bool linear = true;
+
+    static constexpr bool F_nz(int i, int j)
+    {
+        return i == j || (i < 4 && j == i + 2) || (i < 2 && j == i + 4);
+    }
+
+    static void propagate(double* s, double dt)
+    {
+        const double h = 0.5 * dt * dt;
+        s[0] += dt * s[2] + h * s[4];
+        s[1] += dt * s[3] + h * s[5];
+        s[2] += dt * s[4];
+        s[3] += dt * s[5];
+    }
+
+    static void transition(const double* /*s*/, double dt, double F[N][N])
+    {
+        const double h = 0.5 * dt * dt;
+        for (int i = 0; i < N; ++i) F[i][i] = 1.0;
+        F[0][2] = dt; F[1][3] = dt;
+        F[2][4] = dt; F[3][5] = dt;
+        F[0][4] = h;  F[1][5] = h;
+    }
+
+    static double initial_var(int i) { return i < 2 ? 10.0 : (i < 4 ? 100.0 : 1.0); }
+    static double process_var(int /*i*/) { return 0.1; }
+};
+
+// Coordinated turn with unknown rate: [x, y, vx, vy, omega], omega in rad/s.
+// Nonlinear, so the filter runs as an EKF on the Jacobian.
+struct CoordinatedTurn
+{
+    static constexpr int N = 5;
+    static constexpr bool linear = false;
+
+    static constexpr bool F_nz(int i, int j)
+    {
+        return i == j || (i < 4 && j >= 2);
+    }
+
+    static void propagate(double* s, double dt)
+    {
+        const double w = s[4], vx = s[2], vy = s[3];
+        double a, b;  // sin(w dt)/w, (1 - cos(w dt))/w
+        if (std::fabs(w) < 1e-9)
+        {
+            a = dt;
+            b = 0.5 * w * dt * dt;
+        }
+        else
+        {
+            a = std::sin(w * dt) / w;
+            b = (1.0 - std::cos(w * dt)) / w;
+        }
+        const double c = std::cos(w * dt), sn = std::sin(w * dt);
+        s[0] += a * vx - b * vy;
+        s[1] += b * vx + a * vy;
+        s[2] = c * vx - sn * vy;
+        s[3] = sn * vx + c * vy;
+    }
+
+    static void transition(const double* s, double dt, double F[N][N])
+    {
+        const double w = s[4], vx = s[2], vy = s[3];
+        const double c = std::cos(w * dt), sn = std::sin(w * dt);
+
+        double a, b, da, db;  // a, b as in propagate and their d/domega
+        if (std::fabs(w) < 1e-9)
+        {
+            a = dt;
+            b = 0.5 * w * dt * dt;
+            da = 0.0;
+            db = 0.5 * dt * dt;
+        }
+        else
+        {
+            a = sn / w;
+            b = (1.0 - c) / w;
+            da = (dt * c - a) / w;
+            db = (dt * sn - b) / w;
+        }
+
+        for (int i = 0; i < N; ++i) F[i][i] = 1.0;
+        F[0][2] = a;  F[0][3] = -b; F[0][4] = da * vx - db * vy;
+        F[1][2] = b;  F[1][3] = a;  F[1][4] = db * vx + da * vy;
+        F[2][2] = c;  F[2][3] = -sn; F[2][4] = -dt * (sn * vx + c * vy);
+        F[3][2] = sn; F[3][3] = c;   F[3][4] =  dt * (c * vx - sn * vy);
+    }
+
+    static double initial_var(int i) { return i < 2 ? 10.0 : (i < 4 ? 100.0 : 0.01); }
+    static double process_var(int i) { return i < 4 ? 0.1 : 1e-4; }
+};
@@ -0,0 +1,363 @@
+#include "nmea.h"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+
+constexpr double METERS_PER_NM = 1852.0;
+constexpr double EARTH_RADIUS  = 6371000.0;  // [m] mean
+constexpr double DEG           = M_PI / 180.0;
+
+constexpr double DAY           = 86400.0;    // [s]
+
+constexpr std::size_t MAX_FIELDS = 20;
+
+// Split "a,b,c" into at most MAX_FIELDS views; returns the field count.
+std::size_t split_fields(std::string_view s, std::string_view* f)
+{
+    std::size_t n = 0;
+    std::size_t start = 0;
+    for (;;)
+    {
+        std::size_t comma = s.find(',', start);
+        if (n == MAX_FIELDS) return n + 1;  // too many, reported as malformed
+        f[n++] = s.substr(start, comma == std::string_view::npos ? std::string_view::npos
+                                                                  : comma - start);
+        if (comma == std::string_view::npos) return n;
+        start = comma + 1;
+    }
+}
+
+bool parse_double(std::string_view s, double& out)
+{
+    if (!s.empty() && s.front() == '+') s.remove_prefix(1);
+    const char* end = s.data() + s.size();
+    auto res = std::from_chars(s.data(), end, out);
+    return !s.empty() && res.ec == std::errc() && res.ptr == end;
+}
+
+bool parse_int(std::string_view s, int& out)
+{
+    const char* end = s.data() + s.size();
+    auto res = std::from_chars(s.data(), end, out);
+    return !s.empty() && res.ec == std::errc() && res.ptr == end;
+}
+
+int hex_value(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+// hhmmss.ss -> seconds of day
+bool parse_utc(std::string_view s, double& out)
+{
+    if (s.size() < 6) return false;
+    int hh = 0, mm = 0;
+    double ss = 0.0;
+    if (!parse_int(s.substr(0, 2), hh) || !parse_int(s.substr(2, 2), mm) ||
+        !parse_double(s.substr(4), ss))
+        return false;
+    if (hh > 23 || mm > 59 || ss >= 61.0) return false;
+    out = hh * 3600.0 + mm * 60.0 + ss;
+    return true;
+}
+
+// Unpacked AIS payload, one 6-bit value per character.
+struct AisBits
+{
+    static constexpr std::size_t MAX_CHARS = 64;
+
+    std::uint8_t c[MAX_CHARS];
+    std::size_t bits{0};
+
+    bool load(std::string_view payload, int fill)
+    {
+        if (payload.size() > MAX_CHARS) return false;
+        for (std::size_t i = 0; i < payload.size(); ++i)
+        {
+            // '0'..'W' carry 0..39 and '`'..'w' carry 40..63; 'X'..'_' are not used
+            const char ch = payload[i];
+            int v = 0;
+            if (ch >= '0' && ch <= 'W')      v = ch - '0';
+            else if (ch >= '`' && ch <= 'w') v = ch - '`' + 40;
+            else return false;
+            c[i] = static_cast<std::uint8_t>(v);
+        }
+        bits = payload.size() * 6 - static_cast<std::size_t>(fill);
+        return true;
+    }
+
+    std::uint32_t get(std::size_t start, std::size_t len) const
+    {
+        std::uint32_t v = 0;
+        for (std::size_t b = start; b < start + len; ++b)
+            v = (v << 1) | ((c[b / 6] >> (5 - b % 6)) & 1u);
+        return v;
+    }
+
+    std::int32_t get_signed(std::size_t start, std::size_t len) const
+    {
+        std::uint32_t v = get(start, len);
+        if (v & (1u << (len - 1))) v |= ~((1u << len) - 1);  // sign-extend
+        return static_cast<std::int32_t>(v);
+    }
+};
+
+// Bit offsets of the fields we need in a position report.
+struct AisLayout
+{
+    std::size_t sog, lon, lat, cog, second, min_bits;
+};
+
+constexpr AisLayout AIS_CLASS_A{ 50, 61, 89, 116, 137, 168 };  // types 1-3
+constexpr AisLayout AIS_CLASS_B{ 46, 57, 85, 112, 133, 168 };  // type 18
+
+} // namespace
+
+void ContactReport::set_id(std::string_view name)
+{
+    id_len = static_cast<std::uint8_t>(std::min(name.size(), MAX_ID));
+    std::memcpy(id, name.data(), id_len);
+}
+
+void NmeaDecoder::set_origin(double lat_deg, double lon_deg)
+{
+    lat0_ = lat_deg;
+    lon0_ = lon_deg;
+    cos_lat0_ = std::cos(lat_deg * DEG);
+    has_origin_ = true;
+}
+
+double NmeaDecoder::unwrap(double seconds_of_day, double recv_time)
+{
+    if (!has_day_)
+    {
+        day_offset_ = std::round((recv_time - seconds_of_day) / DAY) * DAY;
+        latest_ = seconds_of_day + day_offset_;
+        has_day_ = true;
+    }
+
+    double t = seconds_of_day + day_offset_;
+    if (t < latest_ - DAY / 2)
+    {
+        day_offset_ += DAY;  // past midnight
+        t += DAY;
+    }
+    else if (t > latest_ + DAY / 2)
+    {
+        t -= DAY;            // a late one from before midnight
+    }
+    if (t > latest_) latest_ = t;
+    return t;
+}
+
+NmeaStatus NmeaDecoder::decode(std::string_view s, double recv_time, ContactReport& out)
+{
+    // tag block, e.g. "\s:station,c:1700000000*hh\"
+    if (!s.empty() && s.front() == '\\')
+    {
+        std::size_t end = s.find('\\', 1);
+        if (end == std::string_view::npos) return NmeaStatus::Malformed;
+        s.remove_prefix(end + 1);
+    }
+    while (!s.empty() && (s.back() == '\r' || s.back() == '\n' || s.back() == ' '))
+        s.remove_suffix(1);
+    if (s.size() < 7 || (s.front() != '$' && s.front() != '!'))
+        return NmeaStatus::Malformed;
+
+    std::string_view body = s.substr(1);
+    std::size_t star = body.find('*');
+    if (star != std::string_view::npos)
+    {
+        if (body.size() != star + 3) return NmeaStatus::Malformed;
+        int hi = hex_value(body[star + 1]);
+        int lo = hex_value(body[star + 2]);
+        if (hi < 0 || lo < 0) return NmeaStatus::Malformed;
+        body = body.substr(0, star);
+
+        unsigned sum = 0;
+        for (char ch : body) sum ^= static_cast<unsigned char>(ch);
+        if (sum != static_cast<unsigned>(hi * 16 + lo)) return NmeaStatus::BadChecksum;
+    }
+
+    if (body.size() < 6 || body[5] != ',') return NmeaStatus::Malformed;
+    std::string_view type = body.substr(2, 3);
+    if (type == "TTM") return decode_ttm(body, recv_time, out);
+    if (type == "VDM") return decode_vdm(body, recv_time, out);
+    return NmeaStatus::Unsupported;
+}
+
+NmeaStatus NmeaDecoder::decode_ttm(std::string_view body, double recv_time, ContactReport& out)
+{
+    std::string_view f[MAX_FIELDS];
+    std::size_t n = split_fields(body, f);
+    if (n < 13 || n > MAX_FIELDS) return NmeaStatus::Malformed;
+
+    // relative bearing / course need own heading, which we do not have
+    if (f[4] != "T" || f[7] != "T") return NmeaStatus::Unsupported;
+    if (f[12] == "L") return NmeaStatus::Unsupported;  // lost target
+
+    double unit = 0.0, speed_unit = 0.0;
+    if      (f[10] == "N") { unit = METERS_PER_NM; speed_unit = METERS_PER_NM / 3600.0; }
+    else if (f[10] == "K") { unit = 1000.0;        speed_unit = 1000.0 / 3600.0; }
+    else if (f[10] == "S") { unit = 1609.344;      speed_unit = 1609.344 / 3600.0; }
+    else return NmeaStatus::Malformed;
+
+    int number = 0;
+    double dist = 0.0, bearing = 0.0, speed = 0.0, course = 0.0;
+    if (!parse_int(f[1], number) || !parse_double(f[2], dist) ||
+        !parse_double(f[3], bearing) || !parse_double(f[5], speed) ||
+        !parse_double(f[6], course))
+        return NmeaStatus::Malformed;
+
+    double t = recv_time;
+    if (n > 14 && !f[14].empty())
+    {
+        double sod = 0.0;
+        if (!parse_utc(f[14], sod)) return NmeaStatus::Malformed;
+        t = unwrap(sod, recv_time);
+    }
+
+    const double r = dist * unit;
+    out.time = t;
+    out.x = r * std::cos(bearing * DEG);
+    out.y = r * std::sin(bearing * DEG);
+    out.speed = speed * speed_unit;
+    out.course_deg = course;
+
+    if (!f[11].empty())
+    {
+        out.set_id(f[11]);
+    }
+    else
+    {
+        char name[16];
+        int len = std::snprintf(name, sizeof(name), "TTM%02d", number);
+        out.set_id(std::string_view(name, static_cast<std::size_t>(len)));
+    }
+    return NmeaStatus::Ok;
+}
+
+NmeaStatus NmeaDecoder::decode_vdm(std::string_view body, double recv_time, ContactReport& out)
+{
+    std::string_view f[MAX_FIELDS];
+    std::size_t n = split_fields(body, f);
+    if (n != 7) return NmeaStatus::Malformed;
+
+    // position reports fit in one fragment; multi-part messages are static
+    // and voyage data we do not use
+    if (f[1] != "1") return NmeaStatus::Unsupported;
+
+    int fill = 0;
+    AisBits p;
+    if (!parse_int(f[6], fill) || fill < 0 || fill > 5 || f[5].empty() ||
+        !p.load(f[5], fill))
+        return NmeaStatus::Malformed;
+
+    const std::uint32_t msg = p.get(0, 6);
+    const AisLayout* L = nullptr;
+    if (msg >= 1 && msg <= 3) L = &AIS_CLASS_A;
+    else if (msg == 18)       L = &AIS_CLASS_B;
+    else return NmeaStatus::Unsupported;
+    if (p.bits < L->min_bits) return NmeaStatus::Malformed;
+
+    const std::uint32_t mmsi = p.get(8, 30);
+    const std::uint32_t sog  = p.get(L->sog, 10);      // 0.1 kn, 1023 = n/a
+    const std::int32_t  lon  = p.get_signed(L->lon, 28);  // 1/10000 min
+    const std::int32_t  lat  = p.get_signed(L->lat, 27);
+    const std::uint32_t cog  = p.get(L->cog, 12);      // 0.1 deg, 3600 = n/a
+    const std::uint32_t sec  = p.get(L->second, 6);    // 60+ = n/a
+
+    const double lon_deg = lon / 600000.0;
+    const double lat_deg = lat / 600000.0;
+    if (std::fabs(lon_deg) > 180.0 || std::fabs(lat_deg) > 90.0)
+        return NmeaStatus::NoPosition;
+
+    // own ship sits at (0, 0); a plane around some other vessel would
+    // measure CPA against that vessel
+    if (!has_origin_) return NmeaStatus::NoOrigin;
+
+    // the report carries only its UTC second; take the minute from recv_time
+    double t = recv_time;
+    if (sec < 60)
+    {
+        t = std::floor(recv_time / 60.0) * 60.0 + sec;
+        if (t > recv_time + 30.0) t -= 60.0;
+        else if (t < recv_time - 30.0) t += 60.0;
+    }
+
+    out.time = t;
+    out.x = (lat_deg - lat0_) * DEG * EARTH_RADIUS;
+    out.y = (lon_deg - lon0_) * DEG * EARTH_RADIUS * cos_lat0_;
+    out.speed = (sog < 1023 ? sog * 0.1 : 0.0) * METERS_PER_NM / 3600.0;
+    out.course_deg = cog < 3600 ? cog * 0.1 : 0.0;
+
+    char name[16];
+    int len = std::snprintf(name, sizeof(name), "%09u", static_cast<unsigned>(mmsi));
+    out.set_id(std::string_view(name, static_cast<std::size_t>(len)));
+    return NmeaStatus::Ok;
+}
+
+std::string format_ttm(int number, std::string_view name, double time,
+                       double x, double y, double speed, double course_deg)
+{
+    double bearing = std::atan2(y, x) / DEG;
+    if (bearing < 0.0) bearing += 360.0;
+    double course = std::fmod(course_deg, 360.0);
+    if (course < 0.0) course += 360.0;
+
+    long long cs = std::llround(std::fmod(time, DAY) * 100.0);
+    if (cs < 0) cs += 8640000;
+    const int hh = static_cast<int>(cs / 360000);
+    const int mm = static_cast<int>(cs / 6000 % 60);
+    const double ss = static_cast<double>(cs % 6000) / 100.0;
+
+    char body[160];
+    int len = std::snprintf(body, sizeof(body),
+                            "RATTM,%02d,%.6f,%.5f,T,%.4f,%.3f,T,,,N,%.*s,T,,%02d%02d%05.2f,A",
+                            number % 100, std::hypot(x, y) / METERS_PER_NM, bearing,
+                            speed * 3600.0 / METERS_PER_NM, course,
+                            static_cast<int>(name.size()), name.data(), hh, mm, ss);
+
+    unsigned sum = 0;
+    for (int i = 0; i < len; ++i) sum ^= static_cast<unsigned char>(body[i]);
+
+    char tail[8];
+    std::snprintf(tail, sizeof(tail), "*%02X", sum);
+
+    std::string s;
+    s.reserve(static_cast<std::size_t>(len) + 4);
+    s += '$';
+    s.append(body, static_cast<std::size_t>(len));
+    s += tail;
+    return s;
+}
+
+const char* nmea_status_text(NmeaStatus s)
+{
+    switch (s)
+    {
+        case NmeaStatus::Ok:          return "ok";
+        case NmeaStatus::BadChecksum: return "bad checksum";
+        case NmeaStatus::Unsupported: return "unsupported";
+        case NmeaStatus::Malformed:   return "malformed";
+        case NmeaStatus::NoPosition:  return "no position";
+        case NmeaStatus::NoOrigin:    return "no origin";
+    }
+    return "?";
+}
+
+double utc_seconds()
+{
+    using namespace std::chrono;
+    return duration<double>(system_clock::now().time_since_epoch()).count();
+}
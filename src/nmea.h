@@ -0,0 +1,100 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "io.h"
+
+// One decoded position report. Fixed size with the id stored inline, so it
+// can be copied through a queue slot without touching the heap.
+struct ContactReport
+{
+    static constexpr std::size_t MAX_ID = 23;
+
+    double time;        // [s] UTC, since the midnight the receive clock counts from
+    double x, y;        // [m] north, east of the origin (see course_to_velocity)
+    double speed;       // [m/s]
+    double course_deg;  // true, clockwise from north
+    char id[MAX_ID];
+    std::uint8_t id_len;
+
+    void set_id(std::string_view name);  // truncated to MAX_ID
+    std::string_view name() const { return std::string_view(id, id_len); }
+
+    // For StreamTracker::process; valid while this report lives.
+    MeasurementView view() const
+    {
+        return MeasurementView{ time, name(), x, y, speed, course_deg };
+    }
+};
+
+enum class NmeaStatus : std::uint8_t
+{
+    Ok,
+    BadChecksum,
+    Unsupported,    // well formed, but not a sentence we track from
+    Malformed,
+    NoPosition,     // AIS report without a valid position
+    NoOrigin        // AIS report, but no origin to project it onto
+};
+
+// Decoder for the two sentences that carry contacts:
+//
+//   $--TTM  radar tracked target: range and true bearing from own ship,
+//           true speed and course, target name and UTC time. The target
+//           name becomes the track id ("TTM<nn>" when it is empty).
+//   !AIVDM  AIS position reports, message types 1-3 (class A) and 18
+//           (class B), single fragment. The MMSI becomes the track id and
+//           latitude / longitude are projected onto a flat north / east
+//           plane around the origin, which is own ship's position. Without
+//           an origin AIS reports are not decoded (NoOrigin).
+//
+// AIS reports carry only their UTC second, so they are dated by recv_time
+// and must arrive in real time; a log replayed faster or slower is
+// misdated. TTM sentences carry their full time.
+//
+// Leading tag blocks (\...\) are skipped. A sentence with a checksum must
+// match it; one without is accepted.
+//
+// TTM times are UTC seconds of day. The decoder unwraps them into one
+// continuous scale: the first is placed on the day nearest recv_time and
+// each later one on the day nearest the latest time seen, so a feed that
+// runs through midnight keeps counting past 86400.
+class NmeaDecoder
+{
+public:
+    // own ship's position, the origin of the AIS projection
+    void set_origin(double lat_deg, double lon_deg);
+    bool has_origin() const { return has_origin_; }
+
+    // recv_time [s, UTC, continuous past midnight] dates AIS reports
+    // (refined by their UTC second field) and TTM sentences that carry no
+    // time, and anchors the first TTM time.
+    NmeaStatus decode(std::string_view sentence, double recv_time, ContactReport& out);
+
+private:
+    NmeaStatus decode_ttm(std::string_view body, double recv_time, ContactReport& out);
+    NmeaStatus decode_vdm(std::string_view body, double recv_time, ContactReport& out);
+
+    double unwrap(double seconds_of_day, double recv_time);
+
+    bool has_origin_{false};
+    double lat0_{0.0}, lon0_{0.0};
+    double cos_lat0_{1.0};
+
+    bool has_day_{false};
+    double day_offset_{0.0};  // [s] added to TTM seconds of day
+    double latest_{0.0};      // [s] newest unwrapped TTM time
+};
+
+// "$RATTM,...*hh" for a target at (x, y) [m, north / east of own ship]
+// moving at speed [m/s] on course_deg, reported at time [s of day].
+// Used by the UDP replayer to turn a CSV recording into radar sentences.
+std::string format_ttm(int number, std::string_view name, double time,
+                       double x, double y, double speed, double course_deg);
+
+const char* nmea_status_text(NmeaStatus s);
+
+// Seconds since the Unix epoch (UTC) by the system clock.
+double utc_seconds();
@@ -0,0 +1,226 @@
+#include "pipeline.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+
+#include "instrument.h"
+#include "kalman.h"
+#include "imm.h"
+#include "kalman_bank.h"
+#include "thread_pool.h"
+#include "track_file.h"
+
+namespace
+{
+
+struct Sample
+{
+    double time, x, y;
+};
+
+// Filter n samples, sample(i) giving sample i, and return the last state;
+// speed and course of the first sample seed the velocity.
+template <class At>
+TrackState filter_samples(std::size_t n, At sample, double speed0, double course0,
+                          bool steady_gain)
+{
+    thread_local SteadyGainCache<ConstantVelocity> gains;
+
+    KalmanFilter2D kf;
+    if (steady_gain) kf.set_gain_cache(&gains);
+    Vec2 v0 = course_to_velocity(speed0, course0);
+    const Sample first = sample(0);
+    kf.init(first.x, first.y, v0.x, v0.y);
+
+    double prev_time = first.time;
+
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        const Sample s = sample(i);
+        double t   = s.time;
+        double dt  = t - prev_time;
+        if (dt < 0) dt = 0.0;
+
+        kf.predict(dt);
+        kf.update(s.x, s.y);
+
+        prev_time = t;
+    }
+
+    const auto& P = kf.P;
+    StateCov cov{ P[0][0], P[0][1], P[0][2], P[0][3],
+                           P[1][1], P[1][2], P[1][3],
+                                    P[2][2], P[2][3],
+                                             P[3][3] };
+    return TrackState{ Vec2{kf.getX(), kf.getY()}, Vec2{kf.getVx(), kf.getVy()}, cov };
+}
+
+// Longest first, so that stealing only has to even out the tail.
+template <class Length>
+std::vector<std::size_t> longest_first(std::size_t n, Length length)
+{
+    std::vector<std::size_t> order(n);
+    std::iota(order.begin(), order.end(), std::size_t{0});
+    std::stable_sort(order.begin(), order.end(),
+                     [&](std::size_t a, std::size_t b){ return length(a) > length(b); });
+    return order;
+}
+
+} // namespace
+
+TrackState filter_track(const std::vector<Measurement>& seq, bool steady_gain)
+{
+    return filter_samples(seq.size(),
+                          [&](std::size_t i){ return Sample{ seq[i].time, seq[i].x, seq[i].y }; },
+                          seq.front().speed, seq.front().course_deg, steady_gain);
+}
+
+TrackState filter_track(const TrackBlock& block, bool steady_gain)
+{
+    return filter_samples(block.count,
+                          [&](std::size_t i){ return Sample{ block.time[i], block.x[i], block.y[i] }; },
+                          block.speed[0], block.course[0], steady_gain);
+}
+
+void filter_tracks(const TrackSeries& series,
+                   ThreadPool& pool,
+                   std::vector<TrackState>& out,
+                   bool steady_gain)
+{
+    const auto& seqs = series.series;
+
+    out.assign(seqs.size(), TrackState{});
+
+    std::vector<std::size_t> order = longest_first(seqs.size(),
+                                                   [&](std::size_t i){ return seqs[i].size(); });
+
+    pool.parallel_for(order.size(), [&](std::size_t k)
+    {
+        std::size_t i = order[k];
+        if (seqs[i].empty()) return;
+        CPA_TIMED_SCOPE_N(FilterTrack, seqs[i].size());
+        out[i] = filter_track(seqs[i], steady_gain);
+    });
+}
+
+void filter_tracks(const TrackFile& file,
+                   ThreadPool& pool,
+                   std::vector<TrackState>& out,
+                   bool steady_gain)
+{
+    out.assign(file.num_tracks(), TrackState{});
+
+    std::vector<std::size_t> order = longest_first(file.num_tracks(),
+                                                   [&](std::size_t i){ return file.block(i).count; });
+
+    pool.parallel_for(order.size(), [&](std::size_t k)
+    {
+        std::size_t i = order[k];
+        const TrackBlock& b = file.block(i);
+        if (b.count == 0) return;
+        CPA_TIMED_SCOPE_N(FilterTrack, b.count);
+        out[i] = filter_track(b, steady_gain);
+    });
+}
+
+namespace
+{
+
+// Feed every track sample by sample index to step(dt, zx, zy, active);
+// tracks that have run out are masked out.
+template <class Step>
+void step_by_sample(const std::vector<std::vector<Measurement>>& seqs, Step step)
+{
+    const std::size_t n = seqs.size();
+
+    std::size_t max_len = 0;
+    for (const auto& seq : seqs) max_len = std::max(max_len, seq.size());
+
+    std::vector<double> dt(n, 0.0), zx(n, 0.0), zy(n, 0.0);
+    std::vector<std::uint8_t> active(n, 0);
+
+    for (std::size_t k = 0; k < max_len; ++k)
+    {
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            const auto& seq = seqs[i];
+            active[i] = k < seq.size();
+            if (!active[i]) continue;
+
+            double d = (k == 0) ? 0.0 : seq[k].time - seq[k - 1].time;
+            dt[i] = (d < 0) ? 0.0 : d;
+            zx[i] = seq[k].x;
+            zy[i] = seq[k].y;
+        }
+
+        step(dt.data(), zx.data(), zy.data(), active.data());
+    }
+}
+
+TrackState bank_state(const KalmanBank& b, std::size_t i)
+{
+    StateCov cov{ b.p00[i], b.p01[i], b.p02[i], b.p03[i],
+                            b.p11[i], b.p12[i], b.p13[i],
+                                      b.p22[i], b.p23[i],
+                                                b.p33[i] };
+    return TrackState{ Vec2{b.x[i], b.y[i]}, Vec2{b.vx[i], b.vy[i]}, cov };
+}
+
+template <class Bank>
+void init_from_first(Bank& bank, const std::vector<std::vector<Measurement>>& seqs)
+{
+    bank.resize(seqs.size());
+    for (std::size_t i = 0; i < seqs.size(); ++i)
+    {
+        if (seqs[i].empty()) continue;
+        const Measurement& m0 = seqs[i].front();
+        Vec2 v0 = course_to_velocity(m0.speed, m0.course_deg);
+        bank.init(i, m0.x, m0.y, v0.x, v0.y);
+    }
+}
+
+} // namespace
+
+void filter_tracks_bank(const TrackSeries& series,
+                        std::vector<TrackState>& out)
+{
+    const auto& seqs = series.series;
+    const std::size_t n = seqs.size();
+    out.assign(n, TrackState{});
+
+    KalmanBank bank;
+    init_from_first(bank, seqs);
+
+    step_by_sample(seqs, [&](const double* dt, const double* zx, const double* zy,
+                             const std::uint8_t* active)
+    {
+        bank.predict(dt, active);
+        bank.update(zx, zy, active);
+    });
+
+    for (std::size_t i = 0; i < n; ++i)
+        out[i] = bank_state(bank, i);
+}
+
+void filter_tracks_imm(const TrackSeries& series,
+                       std::vector<TrackState>& out,
+                       const ImmConfig& cfg)
+{
+    const auto& seqs = series.series;
+    const std::size_t n = seqs.size();
+    out.assign(n, TrackState{});
+
+    ImmBank imm;
+    imm.cfg = cfg;
+    init_from_first(imm, seqs);
+
+    step_by_sample(seqs, [&](const double* dt, const double* zx, const double* zy,
+                             const std::uint8_t* active)
+    {
+        imm.step(dt, zx, zy, active);
+    });
+
+    for (std::size_t i = 0; i < n; ++i)
+        out[i] = bank_state(imm.est, i);
+}
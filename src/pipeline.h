@@ -0,0 +1,55 @@
+#pragma once
+#include <vector>
+
+#include "cpa.h"
+#include "cpa_prob.h"
+#include "imm.h"
+#include "io.h"
+
+class ThreadPool;
+class TrackFile;
+struct TrackBlock;
+
+// Filtered final state of one track.
+struct TrackState
+{
+    Vec2 pos;
+    Vec2 vel;
+    StateCov cov;
+};
+
+// Run KalmanFilter2D over one time-ordered series and return its last state.
+// With steady_gain the filter switches to a cached constant gain once its
+// covariance has converged for a regular sampling interval (see
+// SteadyGainCache); the cache is per thread.
+TrackState filter_track(const std::vector<Measurement>& seq, bool steady_gain = false);
+
+// Same, reading the columns of a mapped track file block in place.
+TrackState filter_track(const TrackBlock& block, bool steady_gain = false);
+
+// Filter every track; out[id] receives the final state of track id
+// (empty tracks are left zeroed). Tracks are distributed over the pool
+// longest-first with work stealing. Each result lands in its own slot, so
+// the output does not depend on the number of threads.
+void filter_tracks(const TrackSeries& series,
+                   ThreadPool& pool,
+                   std::vector<TrackState>& out,
+                   bool steady_gain = false);
+
+// Same, straight from a mapped track file: out[i] receives the final
+// state of block i, and no Measurement rows are built.
+void filter_tracks(const TrackFile& file,
+                   ThreadPool& pool,
+                   std::vector<TrackState>& out,
+                   bool steady_gain = false);
+
+// Same, but all tracks are stepped together in one KalmanBank.
+void filter_tracks_bank(const TrackSeries& series,
+                        std::vector<TrackState>& out);
+
+// Same, with an IMM filter (constant velocity plus port and starboard
+// coordinated turns) so that turning vessels do not lag; the result is
+// the mixed estimate.
+void filter_tracks_imm(const TrackSeries& series,
+                       std::vector<TrackState>& out,
+                       const ImmConfig& cfg = ImmConfig{});
@@ -1,67 +1,237 @@
 #include "radar.h"
 #include <iostream>
 #include <algorithm>
+#include <charconv>
 #include <cmath>
+#include <cstdio>
 
-void print_ascii_radar(
-    const std::vector<std::pair<std::string, Vec2>>& positions,
-    const std::map<std::string, CpaResult>& results,
-    const Vec2& own_pos)
+namespace
 {
-    if (positions.empty())
+
+void append_int(std::string& out, int v)
+{
+    char buf[16];
+    auto res = std::to_chars(buf, buf + sizeof(buf), v);
+    out.append(buf, res.ptr);
+}
+
+// ESC[row;colH, 1-based
+void append_move(std::string& out, int row, int col)
+{
+    out += "\x1b[";
+    append_int(out, row);
+    out += ';';
+    append_int(out, col);
+    out += 'H';
+}
+
+const char LEGEND[] = "Legend: O = ownship, X = target, C = collision risk";
+
+} // namespace
+
+RadarRenderer::RadarRenderer(const RadarConfig& cfg)
+    : cfg_(cfg), size_(std::max(cfg.size, 3))
+{
+    cells_.resize(static_cast<std::size_t>(size_) * size_);
+    background_.resize(cells_.size());
+    prev_.resize(cells_.size());
+}
+
+void RadarRenderer::set_scale(double max_abs)
+{
+    if (max_abs == max_abs_ && scale_ > 0.0) return;
+
+    const int center = size_ / 2;
+    max_abs_ = max_abs;
+    scale_ = (max_abs <= 0.0) ? 1.0 : (max_abs / static_cast<double>(center));
+
+    std::fill(background_.begin(), background_.end(), '.');
+    if (cfg_.ring_spacing > 0.0)
     {
-        std::cout << "No targets for radar.\n";
-        return;
+        // a cell is on a ring when its centre is within half a cell of it
+        for (int r = 0; r < size_; ++r)
+            for (int c = 0; c < size_; ++c)
+            {
+                double d = std::hypot(c - center, r - center) * scale_;
+                double k = std::round(d / cfg_.ring_spacing);
+                if (k >= 1.0 && std::fabs(d - k * cfg_.ring_spacing) < 0.5 * scale_)
+                    background_[static_cast<std::size_t>(r) * size_ + c] = ':';
+            }
     }
+    background_[static_cast<std::size_t>(center) * size_ + center] = 'O';
+}
 
-    const int gridSize = 41;
-    const int center   = gridSize / 2;
+void RadarRenderer::append_header()
+{
+    char buf[160];
+    std::snprintf(buf, sizeof(buf), "Approx. scale: %.1f m ~ %.1f cells\n",
+                  max_abs_, static_cast<double>(size_ / 2));
 
-    std::vector<std::vector<char>> grid(
-        gridSize, std::vector<char>(gridSize, '.'));
+    header_.clear();
+    header_ += "=== Radar View (";
+    header_ += cfg_.caption;
+    header_ += ") ===\nTop = +Y, Right = +X\n";
+    header_ += buf;
+}
 
-    (void)own_pos;
-    grid[center][center] = 'O';
+void RadarRenderer::draw(std::size_t n, const double* x, const double* y,
+                         const std::uint8_t* risk, const Vec2& own_pos)
+{
+    double max_abs = cfg_.range;
+    if (max_abs <= 0.0)
+    {
+        max_abs = 1.0;
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            max_abs = std::max(max_abs, std::fabs(x[i] - own_pos.x));
+            max_abs = std::max(max_abs, std::fabs(y[i] - own_pos.y));
+        }
+    }
+    set_scale(max_abs);
+    append_header();
+
+    std::copy(background_.begin(), background_.end(), cells_.begin());
 
-    double maxAbs = 1.0;
-    for (const auto& p : positions)
+    const int center = size_ / 2;
+    const double inv_scale = 1.0 / scale_;
+    for (std::size_t i = 0; i < n; ++i)
     {
-        const auto& pos = p.second;
-        maxAbs = std::max(maxAbs, std::fabs(pos.x));
-        maxAbs = std::max(maxAbs, std::fabs(pos.y));
+        // bounds test in double: far or non-finite targets would overflow the cast
+        const double dc = std::round((x[i] - own_pos.x) * inv_scale);
+        const double dr = std::round((y[i] - own_pos.y) * inv_scale);
+        if (!(std::fabs(dc) <= center && std::fabs(dr) <= center)) continue;
+        const int col = center + static_cast<int>(dc);
+        const int row = center - static_cast<int>(dr);
+
+        char& cell = cells_[static_cast<std::size_t>(row) * size_ + col];
+        if (cell != 'O')
+            cell = risk[i] ? 'C' : 'X';
     }
+}
 
-    const double halfCells = static_cast<double>(center);
-    const double scale     = (maxAbs <= 0.0) ? 1.0 : (maxAbs / halfCells);
+void RadarRenderer::draw(const std::vector<Vec2>& positions,
+                         const std::vector<CpaResult>& results,
+                         const Vec2& own_pos)
+{
+    const std::size_t n = positions.size();
+    xs_.resize(n);
+    ys_.resize(n);
+    risk_.resize(n);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        xs_[i] = positions[i].x;
+        ys_[i] = positions[i].y;
+        risk_[i] = (i < results.size() && results[i].collision_risk) ? 1 : 0;
+    }
+    draw(n, xs_.data(), ys_.data(), risk_.data(), own_pos);
+}
 
-    for (const auto& p : positions)
+void RadarRenderer::append_frame()
+{
+    out_ += header_;
+    out_ += '\n';
+    for (int r = 0; r < size_; ++r)
     {
-        const std::string& id = p.first;
-        const Vec2& pos = p.second;
+        out_.append(&cells_[static_cast<std::size_t>(r) * size_], static_cast<std::size_t>(size_));
+        out_ += '\n';
+    }
+    out_ += '\n';
+    out_ += LEGEND;
+    if (cfg_.ring_spacing > 0.0)
+    {
+        char buf[64];
+        std::snprintf(buf, sizeof(buf), ", : = range ring (%.0f m)", cfg_.ring_spacing);
+        out_ += buf;
+    }
+    out_ += "\n\n";
+}
 
-        int col = center + static_cast<int>(std::round(pos.x / scale));
-        int row = center - static_cast<int>(std::round(pos.y / scale));
+void RadarRenderer::render(std::ostream& os)
+{
+    out_.clear();
+    append_frame();
+    os.write(out_.data(), static_cast<std::streamsize>(out_.size()));
+}
 
-        if (row < 0 || row >= gridSize || col < 0 || col >= gridSize) continue;
+void RadarRenderer::render_diff(std::ostream& os)
+{
+    if (!has_prev_)
+    {
+        // home and clear, then the full frame
+        out_ = "\x1b[H\x1b[2J";
+        append_frame();
+        os.write(out_.data(), static_cast<std::streamsize>(out_.size()));
+        prev_ = cells_;
+        prev_header_ = header_;
+        has_prev_ = true;
+        os.flush();
+        return;
+    }
 
-        auto it = results.find(id);
-        bool risk = (it != results.end()) ? it->second.collision_risk : false;
-        char symbol = risk ? 'C' : 'X';
+    out_.clear();
 
-        if (grid[row][col] != 'O')
-            grid[row][col] = symbol;
+    const int header_lines = static_cast<int>(std::count(header_.begin(), header_.end(), '\n'));
+    // title lines that changed
+    std::size_t a = 0, b = 0;
+    for (int line = 1; a < header_.size(); ++line)
+    {
+        std::size_t ea = header_.find('\n', a);
+        std::size_t eb = prev_header_.find('\n', b);
+        if (eb == std::string::npos) eb = prev_header_.size();
+        if (header_.compare(a, ea - a, prev_header_, b, eb - b) != 0)
+        {
+            append_move(out_, line, 1);
+            out_.append(header_, a, ea - a);
+            out_ += "\x1b[K";
+        }
+        a = ea + 1;
+        b = std::min(eb + 1, prev_header_.size());
     }
+    prev_header_ = header_;
 
-    std::cout << "=== Radar View (filtered final positions) ===\n";
-    std::cout << "Top = +Y, Right = +X\n";
-    std::cout << "Approx. scale: " << maxAbs
-              << " m ~ " << halfCells << " cells\n\n";
+    // grid row r is terminal row header_lines + 2 + r (after a blank line)
+    for (int r = 0; r < size_; ++r)
+    {
+        const std::size_t base = static_cast<std::size_t>(r) * size_;
+        for (int c = 0; c < size_; )
+        {
+            if (cells_[base + c] == prev_[base + c])
+            {
+                ++c;
+                continue;
+            }
+            int end = c + 1;
+            while (end < size_ && cells_[base + end] != prev_[base + end]) ++end;
+
+            append_move(out_, header_lines + 2 + r, c + 1);
+            out_.append(&cells_[base + c], static_cast<std::size_t>(end - c));
+            c = end;
+        }
+    }
+
+    if (!out_.empty())
+    {
+        // park the cursor below the legend
+        append_move(out_, header_lines + size_ + 5, 1);
+        os.write(out_.data(), static_cast<std::streamsize>(out_.size()));
+        os.flush();
+    }
+    prev_ = cells_;
+}
 
-    for (int r = 0; r < gridSize; ++r)
+void print_ascii_radar(
+    const std::vector<Vec2>& positions,
+    const std::vector<CpaResult>& results,
+    const Vec2& own_pos)
+{
+    if (positions.empty())
     {
-        for (int c = 0; c < gridSize; ++c)
-            std::cout << grid[r][c];
-        std::cout << "\n";
+        std::cout << "No targets for radar.\n";
+        return;
     }
-    std::cout << "\nLegend: O = ownship, X = target, C = collision risk\n\n";
+
+    // reused between calls
+    static thread_local RadarRenderer radar;
+    radar.draw(positions, results, own_pos);
+    radar.render(std::cout);
 }
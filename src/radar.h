@@ -1,10 +1,80 @@
 #pragma once
-#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
 #include <string>
-#include <map>
+#include <vector>
 #include "cpa.h"
 
+struct RadarConfig
+{
+    int size{41};               // cells per side (odd keeps own ship centred)
+    double range{0.0};          // [m] from own ship to the edge; 0 = fit the farthest target
+    double ring_spacing{0.0};   // [m] between range rings; 0 = none
+    std::string caption{"filtered final positions"};
+};
+
+// ASCII radar in a flat framebuffer that is kept between frames.
+//
+// Each frame is composed into one string and written with a single
+// ostream::write. The background (dots, range rings, own ship) is only
+// rebuilt when the scale changes. In terminal mode (render_diff) the
+// first frame clears the screen and later frames emit ANSI cursor moves
+// for the runs of cells that changed since the previous frame.
+class RadarRenderer
+{
+public:
+    explicit RadarRenderer(const RadarConfig& cfg = RadarConfig{});
+
+    // Plot n targets (x, y absolute, risk as 0 / 1 bytes) relative to own
+    // ship into the framebuffer.
+    void draw(std::size_t n, const double* x, const double* y,
+              const std::uint8_t* risk, const Vec2& own_pos);
+    // Same, from per-target vectors indexed by TrackId.
+    void draw(const std::vector<Vec2>& positions,
+              const std::vector<CpaResult>& results,
+              const Vec2& own_pos);
+
+    // Whole frame: title, grid and legend.
+    void render(std::ostream& os);
+    // Changes since the last render_diff (everything on the first call).
+    void render_diff(std::ostream& os);
+
+    // Text in the title line, e.g. the scan time.
+    void set_caption(const std::string& caption) { cfg_.caption = caption; }
+
+    // Force the next render_diff to redraw the whole screen.
+    void reset_diff() { has_prev_ = false; }
+
+    int size() const { return size_; }
+    const std::vector<char>& cells() const { return cells_; }
+
+private:
+    void set_scale(double max_abs);
+    void append_header();
+    void append_frame();
+
+    RadarConfig cfg_;
+    int size_;
+
+    double max_abs_{0.0};
+    double scale_{0.0};
+    std::vector<char> background_;
+    std::vector<char> cells_;
+    std::vector<char> prev_;
+    bool has_prev_{false};
+
+    std::vector<double> xs_, ys_;         // for the vector overload
+    std::vector<std::uint8_t> risk_;
+
+    std::string header_;
+    std::string prev_header_;
+    std::string out_;
+};
+
+// positions[id] and results[id] are indexed by TrackId.
+// Prints the default 41x41 view, scaled to the farthest target.
 void print_ascii_radar(
-    const std::vector<std::pair<std::string, Vec2>>& positions,
-    const std::map<std::string, CpaResult>& results,
+    const std::vector<Vec2>& positions,
+    const std::vector<CpaResult>& results,
     const Vec2& own_pos);
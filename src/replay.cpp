@@ -0,0 +1,177 @@
+#include "replay.h"
+#include "json_writer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iomanip>
+#include <thread>
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+// 64-bit FNV-1a
+struct Digest
+{
+    std::uint64_t h{1469598103934665603ull};
+
+    void bytes(const void* p, std::size_t n)
+    {
+        const unsigned char* b = static_cast<const unsigned char*>(p);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            h ^= b[i];
+            h *= 1099511628211ull;
+        }
+    }
+
+    template <class T>
+    void add(const T& v) { bytes(&v, sizeof(v)); }
+};
+
+void digest_snapshot(Digest& d, const ScanSnapshot& snap)
+{
+    d.add(snap.time);
+    d.add(static_cast<std::uint64_t>(snap.measurements));
+    const std::size_t n = snap.live->size();
+    d.add(static_cast<std::uint64_t>(n));
+    d.bytes(snap.live->data(), n * sizeof(TrackId));
+    d.bytes(snap.x, n * sizeof(double));
+    d.bytes(snap.y, n * sizeof(double));
+    const CpaResultBlock& c = *snap.cpa;
+    d.bytes(c.cpa_distance.data(), n * sizeof(double));
+    d.bytes(c.tcpa.data(), n * sizeof(double));
+    d.bytes(c.collision_risk.data(), n);
+    d.bytes(c.closing.data(), n);
+    d.bytes(c.valid.data(), n);
+}
+
+// Recording time at which the scan starting at t has all its data.
+double release_time(double t, double period)
+{
+    return period > 0.0 ? (std::floor(t / period) + 1.0) * period : t;
+}
+
+double seconds_since(Clock::time_point t0)
+{
+    return std::chrono::duration<double>(Clock::now() - t0).count();
+}
+
+} // namespace
+
+ReplayReport run_replay(const TrackSeries& series,
+                        const Vec2& own_pos,
+                        const Vec2& own_vel,
+                        const ReplayConfig& cfg,
+                        NdjsonWriter* ndjson)
+{
+    ReplayReport r;
+    r.tracks = series.size();
+
+    const bool paced = cfg.speed > 0.0;
+    r.factor = paced ? cfg.speed : 1.0;
+    const double period = cfg.scan.period;
+
+    ScanEngine engine(series, own_pos, own_vel, cfg.scan);
+    ScanSnapshot snap;
+    Digest digest;
+
+    if (engine.done()) return r;
+    const double origin = release_time(engine.next_time(), period);
+    double first_time = 0.0;
+    double live_sum = 0.0;
+
+    // schedule time: wall seconds since t0 when paced, simulated otherwise
+    double finish = 0.0;
+    const Clock::time_point t0 = Clock::now();
+
+    while (!engine.done())
+    {
+        const double due = (release_time(engine.next_time(), period) - origin) / r.factor;
+        if (paced)
+            std::this_thread::sleep_until(
+                t0 + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(due)));
+
+        const Clock::time_point a = Clock::now();
+        engine.next(snap);
+        const double busy = std::chrono::duration<double>(Clock::now() - a).count();
+
+        finish = paced ? seconds_since(t0) : std::max(finish, due) + busy;
+
+        if (r.scans == 0) first_time = snap.time;
+        ++r.scans;
+        r.measurements += snap.measurements;
+        live_sum += static_cast<double>(snap.live->size());
+        r.span = snap.time - first_time;
+        r.busy += busy;
+        r.max_scan = std::max(r.max_scan, busy);
+
+        if (!engine.done())
+        {
+            const double next_due = (release_time(engine.next_time(), period) - origin) / r.factor;
+            if (finish > next_due)
+            {
+                const double behind = finish - next_due;
+                ++r.behind;
+                r.max_behind = std::max(r.max_behind, behind);
+                if (r.late.size() < cfg.max_listed)
+                    r.late.push_back(LateScan{ snap.time, busy, behind });
+            }
+        }
+
+        digest_snapshot(digest, snap);
+        if (ndjson) ndjson->write_scan(snap, series.ids);
+    }
+
+    r.wall = seconds_since(t0);
+    r.mean_live = live_sum / static_cast<double>(r.scans);
+    r.digest = digest.h;
+    if (ndjson) ndjson->flush();
+    return r;
+}
+
+void print_replay_report(const ReplayReport& r, std::ostream& os)
+{
+    const double rt = r.realtime_factor();
+
+    os << std::fixed << std::setprecision(1)
+       << "=== Replay ===\n"
+       << "scans:            " << r.scans << " (" << r.measurements << " measurements, "
+       << r.tracks << " tracks, " << r.mean_live << " live per scan)\n"
+       << "recording span:   " << r.span << " s\n"
+       << std::setprecision(3)
+       << "wall time:        " << r.wall << " s\n"
+       << "processing:       " << r.busy << " s (slowest scan " << r.max_scan * 1e3 << " ms)\n";
+
+    os << std::setprecision(0);
+    if (r.busy > 0.0)
+        os << "rate:             " << static_cast<double>(r.measurements) / r.busy
+           << " measurements/s, " << static_cast<double>(r.scans) / r.busy << " scans/s\n";
+
+    os << std::setprecision(1);
+    if (rt > 0.0)
+    {
+        os << "real-time factor: " << rt << "x (one core, "
+           << 100.0 * (1.0 - 1.0 / rt) << " % idle at 1x)\n";
+        if (r.factor != 1.0)
+            os << "at the speed:     " << r.factor << "x, "
+               << 100.0 * (1.0 - r.factor / rt) << " % idle\n";
+        os << std::setprecision(0)
+           << "capacity:         ~" << r.mean_live * rt << " tracks per core at this update rate\n";
+    }
+
+    os << std::setprecision(3)
+       << "fell behind:      " << r.behind << " scan(s), worst " << r.max_behind * 1e3 << " ms\n";
+    for (const LateScan& l : r.late)
+        os << "  t=" << std::setprecision(1) << l.time << " s: " << std::setprecision(3)
+           << l.busy * 1e3 << " ms of work, " << l.behind * 1e3 << " ms behind\n";
+    if (r.behind > r.late.size())
+        os << "  ... " << r.behind - r.late.size() << " more\n";
+
+    char digest[24];
+    std::snprintf(digest, sizeof(digest), "%016llx", static_cast<unsigned long long>(r.digest));
+    os << "digest:           " << digest << "\n";
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+#include "scan.h"
+
+class NdjsonWriter;
+
+struct ReplayConfig
+{
+    // Recording seconds per wall-clock second; 0 = as fast as possible.
+    double speed{0.0};
+    ScanConfig scan;
+    // Scans that fell behind listed individually (all are counted).
+    std::size_t max_listed{20};
+};
+
+// A scan that was not finished when the next one became due.
+struct LateScan
+{
+    double time;        // [s] recording time
+    double busy;        // [s] processing time
+    double behind;      // [s] past the next scan's due time
+};
+
+struct ReplayReport
+{
+    std::size_t scans{0};
+    std::size_t measurements{0};
+    std::size_t tracks{0};
+    double mean_live{0.0};      // live tracks per scan
+    double span{0.0};           // [s] recording time from first to last scan
+    double wall{0.0};           // [s] elapsed, pacing included
+    double busy{0.0};           // [s] in ScanEngine::next
+    double max_scan{0.0};       // [s] slowest scan
+    double factor{1.0};         // schedule the scans were judged against (x real time)
+    std::size_t behind{0};      // scans that fell behind
+    double max_behind{0.0};     // [s]
+    std::vector<LateScan> late; // the first max_listed of them
+    std::uint64_t digest{0};    // FNV-1a over every snapshot
+
+    // Recording seconds processed per busy second.
+    double realtime_factor() const { return busy > 0.0 ? span / busy : 0.0; }
+};
+
+// Replay a recording through the ScanEngine on the calling thread.
+//
+// Scan k becomes due when its data is complete: at its timestamp, or at
+// the end of its period with cfg.scan.period > 0, divided by the speed
+// and counted from the start. With speed > 0 the driver sleeps until each
+// scan is due; at max speed it runs back to back and the same schedule is
+// simulated at 1x from the measured processing times. Either way a scan
+// falls behind when it finishes after the next scan is due.
+//
+// The snapshots do not depend on pacing or timing, so the digest is the
+// same for every speed and run; it changes only with the input or the
+// filter / CPA code. Snapshots also go to ndjson when given (outside the
+// timed part).
+ReplayReport run_replay(const TrackSeries& series,
+                        const Vec2& own_pos,
+                        const Vec2& own_vel,
+                        const ReplayConfig& cfg,
+                        NdjsonWriter* ndjson = nullptr);
+
+// Rate, headroom against real time and against the chosen speed, the
+// number of tracks one core could follow at this update rate, the late
+// scans and the digest.
+void print_replay_report(const ReplayReport& r, std::ostream& os);
@@ -0,0 +1,141 @@
+#include "scan.h"
+#include "instrument.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+// min-heap on (time, id) so that simultaneous rows apply in track order
+struct Later
+{
+    template <class H>
+    bool operator()(const H& a, const H& b) const
+    {
+        return a.time != b.time ? a.time > b.time : a.id > b.id;
+    }
+};
+}
+
+ScanEngine::ScanEngine(const TrackSeries& series,
+                       const Vec2& own_pos,
+                       const Vec2& own_vel,
+                       const ScanConfig& cfg)
+    : series_(series), own_pos_(own_pos), own_vel_(own_vel), cfg_(cfg)
+{
+    const std::size_t n = series.size();
+
+    heap_.reserve(n);
+    for (TrackId id = 0; id < n; ++id)
+        if (!series.series[id].empty())
+            heap_.push_back(Head{ series.series[id].front().time, id, 0 });
+    std::make_heap(heap_.begin(), heap_.end(), Later{});
+
+    filters_.resize(n);
+    last_time_.assign(n, 0.0);
+    started_.assign(n, 0);
+
+    live_.reserve(n);
+    x_.resize(n); y_.resize(n); vx_.resize(n); vy_.resize(n);
+    cpa_.resize(n);
+}
+
+void ScanEngine::apply(const Head& h)
+{
+    const Measurement& m = series_.series[h.id][h.idx];
+    KalmanFilter2D& kf = filters_[h.id];
+
+    if (!started_[h.id])
+    {
+        Vec2 v0 = course_to_velocity(m.speed, m.course_deg);
+        kf.init(m.x, m.y, v0.x, v0.y);
+        last_time_[h.id] = m.time;
+        started_[h.id] = 1;
+    }
+
+    double dt = m.time - last_time_[h.id];
+    if (dt < 0) dt = 0.0;
+
+    kf.predict(dt);
+    kf.update(m.x, m.y);
+    last_time_[h.id] = m.time;
+}
+
+bool ScanEngine::next(ScanSnapshot& snap)
+{
+    if (heap_.empty()) return false;
+    CPA_TIMER(timer, Scan);
+
+    const double first = heap_.front().time;
+    const double end = (cfg_.period > 0.0)
+        ? (std::floor(first / cfg_.period) + 1.0) * cfg_.period
+        : first;
+
+    double scan_time = first;
+    std::size_t applied = 0;
+
+    while (!heap_.empty())
+    {
+        const Head& top = heap_.front();
+        if (cfg_.period > 0.0 ? !(top.time < end) : top.time != end) break;
+
+        std::pop_heap(heap_.begin(), heap_.end(), Later{});
+        Head h = heap_.back();
+        heap_.pop_back();
+
+        apply(h);
+        scan_time = h.time;
+        ++applied;
+
+        if (++h.idx < series_.series[h.id].size())
+        {
+            h.time = series_.series[h.id][h.idx].time;
+            heap_.push_back(h);
+            std::push_heap(heap_.begin(), heap_.end(), Later{});
+        }
+    }
+
+    // extrapolate every live track to the scan time
+    live_.clear();
+    for (TrackId id = 0; id < filters_.size(); ++id)
+    {
+        if (!started_[id]) continue;
+        double age = scan_time - last_time_[id];
+        if (age > cfg_.max_coast) continue;
+
+        const KalmanFilter2D& kf = filters_[id];
+        std::size_t k = live_.size();
+        live_.push_back(id);
+        x_[k]  = kf.getX() + kf.getVx() * age;
+        y_[k]  = kf.getY() + kf.getVy() * age;
+        vx_[k] = kf.getVx();
+        vy_[k] = kf.getVy();
+    }
+
+    compute_cpa_batch(own_pos_, own_vel_,
+                      x_.data(), y_.data(), vx_.data(), vy_.data(),
+                      live_.size(), cpa_);
+
+    CPA_SET_ITEMS(timer, applied);
+    snap.time = scan_time;
+    snap.measurements = applied;
+    snap.risks = 0;
+    snap.has_min_cpa = false;
+    for (std::size_t k = 0; k < live_.size(); ++k)
+    {
+        snap.risks += cpa_.collision_risk[k];
+        if (cpa_.valid[k] && cpa_.closing[k] &&
+            (!snap.has_min_cpa || cpa_.cpa_distance[k] < snap.min_cpa))
+        {
+            snap.min_cpa = cpa_.cpa_distance[k];
+            snap.min_cpa_id = live_[k];
+            snap.has_min_cpa = true;
+        }
+    }
+    snap.live = &live_;
+    snap.x = x_.data();
+    snap.y = y_.data();
+    snap.cpa = &cpa_;
+
+    return true;
+}
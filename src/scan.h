@@ -0,0 +1,84 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+#include "cpa.h"
+#include "io.h"
+#include "kalman.h"
+
+struct ScanConfig
+{
+    // Measurements in [k*period, (k+1)*period) form one scan; 0 makes every
+    // distinct timestamp its own scan.
+    double period{0.0};
+    // A track stays in the picture this long after its last measurement.
+    double max_coast{10.0};
+};
+
+// CPA picture of all live tracks at one scan time.
+struct ScanSnapshot
+{
+    double time{0.0};
+    std::size_t measurements{0};     // applied in this scan
+    std::size_t risks{0};
+    double min_cpa{0.0};             // over valid, closing tracks
+    TrackId min_cpa_id{0};
+    bool has_min_cpa{false};
+
+    // Live tracks, their positions and their CPA at `time`, parallel
+    // arrays; valid until the next call to ScanEngine::next.
+    const std::vector<TrackId>* live{nullptr};
+    const double* x{nullptr};
+    const double* y{nullptr};
+    const CpaResultBlock* cpa{nullptr};
+};
+
+// Replays a TrackSeries in global time order, one scan at a time.
+//
+// A heap over the next measurement of every track merges the series; each
+// measurement updates its track's filter. At the end of a scan every live
+// track is extrapolated to the scan time and the whole picture goes
+// through compute_cpa_batch, so all targets are compared at the same
+// epoch. All buffers are sized once in the constructor; next() does not
+// allocate.
+class ScanEngine
+{
+public:
+    ScanEngine(const TrackSeries& series,
+               const Vec2& own_pos,
+               const Vec2& own_vel,
+               const ScanConfig& cfg = ScanConfig{});
+
+    // Process the next scan; false when all measurements are consumed.
+    bool next(ScanSnapshot& snap);
+
+    // Time of the next unprocessed measurement (undefined when done).
+    double next_time() const { return heap_.front().time; }
+    bool done() const { return heap_.empty(); }
+
+    const KalmanFilter2D& filter(TrackId id) const { return filters_[id]; }
+
+private:
+    struct Head
+    {
+        double time;
+        TrackId id;
+        std::size_t idx;
+    };
+
+    void apply(const Head& h);
+
+    const TrackSeries& series_;
+    Vec2 own_pos_;
+    Vec2 own_vel_;
+    ScanConfig cfg_;
+
+    std::vector<Head> heap_;
+    std::vector<KalmanFilter2D> filters_;
+    std::vector<double> last_time_;
+    std::vector<unsigned char> started_;
+
+    std::vector<TrackId> live_;
+    std::vector<double> x_, y_, vx_, vy_;
+    CpaResultBlock cpa_;
+};
@@ -0,0 +1,154 @@
+#pragma once
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+// Minimal lane abstraction for the batched kernels (KalmanBank, batch CPA).
+// A kernel is written once as a template over a lane type S and
+// instantiated with simd::Wide for the main loop and simd::Scalar for the
+// tail. S provides: V (value), M (mask), width, load/store, set1,
+// comparisons, select, and byte-mask load/store (0 / 1 per lane).
+// Loads and stores are unaligned, so plain std::vector storage is fine.
+
+namespace simd
+{
+
+struct Scalar
+{
+    using V = double;
+    using M = bool;
+    static constexpr std::size_t width = 1;
+
+    static V load(const double* p) { return *p; }
+    static void store(double* p, V a) { *p = a; }
+    static V set1(double a) { return a; }
+    static V sqrt(V a) { return std::sqrt(a); }
+    static V abs(V a) { return std::fabs(a); }
+    static V min(V a, V b) { return a < b ? a : b; }
+    static V max(V a, V b) { return a > b ? a : b; }
+
+    static M lt(V a, V b) { return a < b; }
+    static M ge(V a, V b) { return a >= b; }
+    static M land(M a, M b) { return a && b; }
+    static M lnot(M a) { return !a; }
+    static V select(M m, V a, V b) { return m ? a : b; }
+
+    static M load_mask(const std::uint8_t* p) { return *p != 0; }
+    static void store_mask(std::uint8_t* p, M m) { *p = m ? 1 : 0; }
+};
+
+#if defined(__AVX512F__)
+
+struct Vec512
+{
+    __m512d v;
+};
+
+inline Vec512 operator+(Vec512 a, Vec512 b) { return {_mm512_add_pd(a.v, b.v)}; }
+inline Vec512 operator-(Vec512 a, Vec512 b) { return {_mm512_sub_pd(a.v, b.v)}; }
+inline Vec512 operator*(Vec512 a, Vec512 b) { return {_mm512_mul_pd(a.v, b.v)}; }
+inline Vec512 operator/(Vec512 a, Vec512 b) { return {_mm512_div_pd(a.v, b.v)}; }
+inline Vec512 operator-(Vec512 a) { return {_mm512_sub_pd(_mm512_setzero_pd(), a.v)}; }
+
+struct Wide
+{
+    using V = Vec512;
+    using M = __mmask8;
+    static constexpr std::size_t width = 8;
+
+    static V load(const double* p) { return {_mm512_loadu_pd(p)}; }
+    static void store(double* p, V a) { _mm512_storeu_pd(p, a.v); }
+    static V set1(double a) { return {_mm512_set1_pd(a)}; }
+    // same as _mm512_sqrt_pd, whose GCC 12 header trips -Wmaybe-uninitialized
+    static V sqrt(V a) { return {_mm512_maskz_sqrt_pd(0xFF, a.v)}; }
+    static V abs(V a) { return {_mm512_abs_pd(a.v)}; }
+    static V min(V a, V b) { return {_mm512_min_pd(a.v, b.v)}; }
+    static V max(V a, V b) { return {_mm512_max_pd(a.v, b.v)}; }
+
+    static M lt(V a, V b) { return _mm512_cmp_pd_mask(a.v, b.v, _CMP_LT_OQ); }
+    static M ge(V a, V b) { return _mm512_cmp_pd_mask(a.v, b.v, _CMP_GE_OQ); }
+    static M land(M a, M b) { return static_cast<M>(a & b); }
+    static M lnot(M a) { return static_cast<M>(~a); }
+    static V select(M m, V a, V b) { return {_mm512_mask_blend_pd(m, b.v, a.v)}; }
+
+    static M load_mask(const std::uint8_t* p)
+    {
+        __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p));
+        int zero = _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_setzero_si128()));
+        return static_cast<M>(~zero & 0xFF);
+    }
+    static void store_mask(std::uint8_t* p, M m)
+    {
+        for (std::size_t k = 0; k < width; ++k)
+            p[k] = static_cast<std::uint8_t>((m >> k) & 1u);
+    }
+};
+
+inline const char* isa_name() { return "avx512"; }
+
+#elif defined(__AVX2__)
+
+struct Vec256
+{
+    __m256d v;
+};
+
+inline Vec256 operator+(Vec256 a, Vec256 b) { return {_mm256_add_pd(a.v, b.v)}; }
+inline Vec256 operator-(Vec256 a, Vec256 b) { return {_mm256_sub_pd(a.v, b.v)}; }
+inline Vec256 operator*(Vec256 a, Vec256 b) { return {_mm256_mul_pd(a.v, b.v)}; }
+inline Vec256 operator/(Vec256 a, Vec256 b) { return {_mm256_div_pd(a.v, b.v)}; }
+inline Vec256 operator-(Vec256 a) { return {_mm256_sub_pd(_mm256_setzero_pd(), a.v)}; }
+
+struct Wide
+{
+    using V = Vec256;
+    using M = __m256d;
+    static constexpr std::size_t width = 4;
+
+    static V load(const double* p) { return {_mm256_loadu_pd(p)}; }
+    static void store(double* p, V a) { _mm256_storeu_pd(p, a.v); }
+    static V set1(double a) { return {_mm256_set1_pd(a)}; }
+    static V sqrt(V a) { return {_mm256_sqrt_pd(a.v)}; }
+    static V abs(V a) { return {_mm256_andnot_pd(_mm256_set1_pd(-0.0), a.v)}; }
+    static V min(V a, V b) { return {_mm256_min_pd(a.v, b.v)}; }
+    static V max(V a, V b) { return {_mm256_max_pd(a.v, b.v)}; }
+
+    static M lt(V a, V b) { return _mm256_cmp_pd(a.v, b.v, _CMP_LT_OQ); }
+    static M ge(V a, V b) { return _mm256_cmp_pd(a.v, b.v, _CMP_GE_OQ); }
+    static M land(M a, M b) { return _mm256_and_pd(a, b); }
+    static M lnot(M a) { return _mm256_xor_pd(a, _mm256_castsi256_pd(_mm256_set1_epi64x(-1))); }
+    static V select(M m, V a, V b) { return {_mm256_blendv_pd(b.v, a.v, m)}; }
+
+    static M load_mask(const std::uint8_t* p)
+    {
+        int raw;
+        std::memcpy(&raw, p, sizeof(raw));
+        __m128i bytes = _mm_cvtsi32_si128(raw);
+        __m256i lanes = _mm256_cvtepu8_epi64(bytes);
+        __m256i zero  = _mm256_cmpeq_epi64(lanes, _mm256_setzero_si256());
+        return lnot(_mm256_castsi256_pd(zero));
+    }
+    static void store_mask(std::uint8_t* p, M m)
+    {
+        int bits = _mm256_movemask_pd(m);
+        for (std::size_t k = 0; k < width; ++k)
+            p[k] = static_cast<std::uint8_t>((bits >> k) & 1);
+    }
+};
+
+inline const char* isa_name() { return "avx2"; }
+
+#else
+
+using Wide = Scalar;
+
+inline const char* isa_name() { return "scalar"; }
+
+#endif
+
+} // namespace simd
@@ -0,0 +1,305 @@
+#include "smoother.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#include "instrument.h"
+#include "thread_pool.h"
+
+namespace
+{
+
+constexpr int N = SmoothStep::N;
+
+void pack(const double P[N][N], double* p)
+{
+    int k = 0;
+    for (int i = 0; i < N; ++i)
+        for (int j = i; j < N; ++j)
+            p[k++] = P[i][j];
+}
+
+void unpack(const double* p, double P[N][N])
+{
+    int k = 0;
+    for (int i = 0; i < N; ++i)
+        for (int j = i; j < N; ++j)
+            P[i][j] = P[j][i] = p[k++];
+}
+
+// In place lower Cholesky factor of a symmetric positive definite A.
+bool cholesky(double A[N][N])
+{
+    for (int j = 0; j < N; ++j)
+    {
+        double d = A[j][j];
+        for (int k = 0; k < j; ++k) d -= A[j][k] * A[j][k];
+        if (!(d > 0.0)) return false;
+        d = std::sqrt(d);
+        A[j][j] = d;
+        for (int i = j + 1; i < N; ++i)
+        {
+            double s = A[i][j];
+            for (int k = 0; k < j; ++k) s -= A[i][k] * A[j][k];
+            A[i][j] = s / d;
+        }
+    }
+    return true;
+}
+
+// B = L^-T L^-1 B for each column of B.
+void cholesky_solve(const double L[N][N], double B[N][N])
+{
+    for (int c = 0; c < N; ++c)
+    {
+        for (int i = 0; i < N; ++i)
+        {
+            double s = B[i][c];
+            for (int k = 0; k < i; ++k) s -= L[i][k] * B[k][c];
+            B[i][c] = s / L[i][i];
+        }
+        for (int i = N; i-- > 0; )
+        {
+            double s = B[i][c];
+            for (int k = i + 1; k < N; ++k) s -= L[k][i] * B[k][c];
+            B[i][c] = s / L[i][i];
+        }
+    }
+}
+
+SmoothedPoint make_point(double time, const double x[N], const double P[N][N])
+{
+    StateCov cov{ P[0][0], P[0][1], P[0][2], P[0][3],
+                           P[1][1], P[1][2], P[1][3],
+                                    P[2][2], P[2][3],
+                                             P[3][3] };
+    return SmoothedPoint{ time, TrackState{ Vec2{x[0], x[1]}, Vec2{x[2], x[3]}, cov } };
+}
+
+} // namespace
+
+RtsSmoother::RtsSmoother(const SmootherConfig& cfg)
+    : cfg_(cfg)
+{
+    if (cfg_.lag > 0) steps_.resize(cfg_.lag + 1);
+}
+
+void RtsSmoother::begin()
+{
+    started_ = false;
+    head_ = 0;
+    count_ = 0;
+}
+
+void RtsSmoother::forward(const Measurement& m, SmoothStep& s, SmoothStep* prev)
+{
+    if (!started_)
+    {
+        Vec2 v0 = course_to_velocity(m.speed, m.course_deg);
+        kf_.init(m.x, m.y, v0.x, v0.y);
+        prev_time_ = m.time;
+        started_ = true;
+    }
+
+    double dt = m.time - prev_time_;
+    if (dt < 0) dt = 0.0;
+
+    // gain of the previous step: X = Pp^-1 F Pf, C = Pf F^T Pp^-1 = X^T
+    double X[N][N] = {};
+    if (prev)
+    {
+        double F[N][N] = {};
+        double Pf[N][N];
+        unpack(prev->Pf, Pf);
+        ConstantVelocity::transition(prev->xf, dt, F);
+        for (int i = 0; i < N; ++i)
+            for (int k = 0; k < N; ++k)
+            {
+                if (!ConstantVelocity::F_nz(i, k)) continue;
+                for (int j = 0; j < N; ++j)
+                    X[i][j] += F[i][k] * Pf[k][j];
+            }
+    }
+
+    kf_.predict(dt);
+    std::copy(kf_.x, kf_.x + N, s.xp);
+    pack(kf_.P, s.Pp);
+
+    if (prev)
+    {
+        double L[N][N];
+        std::copy(&kf_.P[0][0], &kf_.P[0][0] + N * N, &L[0][0]);
+        const bool ok = cholesky(L);
+        if (ok) cholesky_solve(L, X);
+        for (int i = 0; i < N; ++i)
+            for (int j = 0; j < N; ++j)
+                prev->C[i][j] = ok ? X[j][i] : 0.0;  // C = 0 keeps the filtered estimate
+    }
+
+    kf_.update(m.x, m.y);
+    std::copy(kf_.x, kf_.x + N, s.xf);
+    pack(kf_.P, s.Pf);
+
+    s.time = m.time;
+    prev_time_ = m.time;
+}
+
+template <class Emit>
+void RtsSmoother::backward(std::size_t count, Emit emit)
+{
+    if (count == 0) return;
+
+    double xs[N], Ps[N][N];
+    const SmoothStep& last = at(count - 1);
+    std::copy(last.xf, last.xf + N, xs);
+    unpack(last.Pf, Ps);
+    emit(count - 1, make_point(last.time, xs, Ps));
+
+    for (std::size_t k = count - 1; k-- > 0; )
+    {
+        const SmoothStep& s = at(k);
+        const SmoothStep& next = at(k + 1);
+
+        double Pf[N][N], Pp[N][N];
+        unpack(s.Pf, Pf);
+        unpack(next.Pp, Pp);
+        const double (&C)[N][N] = s.C;
+
+        double dx[N], dP[N][N];
+        for (int i = 0; i < N; ++i)
+        {
+            dx[i] = xs[i] - next.xp[i];
+            for (int j = 0; j < N; ++j) dP[i][j] = Ps[i][j] - Pp[i][j];
+        }
+
+        for (int i = 0; i < N; ++i)
+        {
+            double v = s.xf[i];
+            for (int j = 0; j < N; ++j) v += C[i][j] * dx[j];
+            xs[i] = v;
+        }
+
+        // Ps = Pf + C dP C^T, symmetric by construction
+        double CdP[N][N] = {};
+        for (int i = 0; i < N; ++i)
+            for (int k2 = 0; k2 < N; ++k2)
+                for (int j = 0; j < N; ++j)
+                    CdP[i][j] += C[i][k2] * dP[k2][j];
+        for (int i = 0; i < N; ++i)
+            for (int j = i; j < N; ++j)
+            {
+                double v = Pf[i][j];
+                for (int k2 = 0; k2 < N; ++k2) v += CdP[i][k2] * C[j][k2];
+                Ps[i][j] = Ps[j][i] = v;
+            }
+
+        emit(k, make_point(s.time, xs, Ps));
+    }
+}
+
+bool RtsSmoother::push(const Measurement& m, SmoothedPoint& out)
+{
+    if (cfg_.lag == 0)
+    {
+        // batch: keep everything, smoothed at flush
+        if (count_ == steps_.size()) steps_.emplace_back();
+        forward(m, steps_[count_], count_ ? &steps_[count_ - 1] : nullptr);
+        ++count_;
+        return false;
+    }
+
+    forward(m, at(count_), count_ ? &at(count_ - 1) : nullptr);
+    ++count_;
+    if (count_ <= cfg_.lag) return false;
+
+    backward(count_, [&](std::size_t k, const SmoothedPoint& p)
+    {
+        if (k == 0) out = p;
+    });
+    head_ = (head_ + 1) % steps_.size();
+    --count_;
+    return true;
+}
+
+void RtsSmoother::flush(std::vector<SmoothedPoint>& out)
+{
+    const std::size_t base = out.size();
+    out.resize(base + count_);
+    backward(count_, [&](std::size_t k, const SmoothedPoint& p) { out[base + k] = p; });
+    head_ = 0;
+    count_ = 0;
+}
+
+void RtsSmoother::smooth(const std::vector<Measurement>& seq, std::vector<SmoothedPoint>& out)
+{
+    begin();
+    out.resize(seq.size());
+    if (seq.empty()) return;
+
+    std::size_t done = 0;
+    if (cfg_.lag == 0)
+    {
+        if (steps_.size() < seq.size()) steps_.resize(seq.size());
+        for (const Measurement& m : seq)
+        {
+            forward(m, steps_[count_], count_ ? &steps_[count_ - 1] : nullptr);
+            ++count_;
+        }
+    }
+    else
+    {
+        for (const Measurement& m : seq)
+            if (push(m, out[done])) ++done;
+    }
+
+    backward(count_, [&](std::size_t k, const SmoothedPoint& p) { out[done + k] = p; });
+    count_ = 0;
+}
+
+void smooth_tracks(const TrackSeries& series,
+                   ThreadPool& pool,
+                   const Vec2& own_pos,
+                   const Vec2& own_vel,
+                   const SmootherConfig& cfg,
+                   std::vector<SmoothedTrack>& out)
+{
+    const auto& seqs = series.series;
+
+    // all output allocated up front, the workers only fill it in
+    out.resize(seqs.size());
+    for (std::size_t i = 0; i < seqs.size(); ++i)
+    {
+        out[i].points.resize(seqs[i].size());
+        out[i].cpa.resize(seqs[i].size());
+    }
+
+    std::vector<std::size_t> order(seqs.size());
+    std::iota(order.begin(), order.end(), std::size_t{0});
+    std::stable_sort(order.begin(), order.end(),
+                     [&](std::size_t a, std::size_t b){ return seqs[a].size() > seqs[b].size(); });
+
+    pool.parallel_for(order.size(), [&](std::size_t k)
+    {
+        std::size_t i = order[k];
+        if (seqs[i].empty()) return;
+        CPA_TIMED_SCOPE_N(SmoothTrack, seqs[i].size());
+
+        thread_local RtsSmoother smoother;
+        thread_local std::vector<double> x, y, vx, vy;
+        if (smoother.lag() != cfg.lag) smoother = RtsSmoother(cfg);
+
+        SmoothedTrack& t = out[i];
+        smoother.smooth(seqs[i], t.points);
+
+        const std::size_t n = t.points.size();
+        x.resize(n); y.resize(n); vx.resize(n); vy.resize(n);
+        for (std::size_t j = 0; j < n; ++j)
+        {
+            const TrackState& s = t.points[j].state;
+            x[j] = s.pos.x;  y[j] = s.pos.y;
+            vx[j] = s.vel.x; vy[j] = s.vel.y;
+        }
+        compute_cpa_batch(own_pos, own_vel, x.data(), y.data(), vx.data(), vy.data(), n, t.cpa);
+    });
+}
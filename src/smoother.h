@@ -0,0 +1,109 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+#include "cpa.h"
+#include "io.h"
+#include "kalman.h"
+#include "pipeline.h"
+
+class ThreadPool;
+
+struct SmootherConfig
+{
+    // Steps of look-ahead for the fixed-lag smoother; 0 smooths each track
+    // over its whole series (full batch).
+    std::size_t lag{0};
+};
+
+// One step of the forward pass: predicted and filtered state, covariances
+// stored as their upper triangles, and the smoother gain to the next step
+// (set once that step has been predicted).
+struct SmoothStep
+{
+    static constexpr int N = KalmanFilter2D::N;
+    static constexpr int NP = N * (N + 1) / 2;
+
+    double time;
+    double xp[N], xf[N];
+    double Pp[NP], Pf[NP];
+    double C[N][N];
+};
+
+// Smoothed state of one measurement step.
+struct SmoothedPoint
+{
+    double time;
+    TrackState state;
+};
+
+// Rauch-Tung-Striebel smoother over KalmanFilter2D.
+//
+// The forward pass is the same filter as filter_track and records every
+// step in a SmoothStep buffer, with the gain
+//     C_k = Pf_k F_{k+1}^T Pp_{k+1}^-1               (Cholesky solve)
+// which only depends on the forward covariances. The backward pass computes
+//     xs_k = xf_k + C_k (xs_{k+1} - xp_{k+1})
+//     Ps_k = Pf_k + C_k (Ps_{k+1} - Pp_{k+1}) C_k^T
+//
+// Full batch (lag 0) keeps the whole series and smooths it in one backward
+// pass. Fixed lag L keeps a ring of L + 1 steps: every push beyond that
+// re-runs the backward pass over the window and emits the step L behind
+// the newest, so memory stays fixed however long the track runs, at O(L)
+// work per step. The buffers only grow, so a smoother reused across
+// tracks stops allocating once it has seen the longest one.
+class RtsSmoother
+{
+public:
+    explicit RtsSmoother(const SmootherConfig& cfg = SmootherConfig{});
+
+    // Smooth one time-ordered series into out (resized to seq.size()).
+    void smooth(const std::vector<Measurement>& seq, std::vector<SmoothedPoint>& out);
+
+    // Streaming, fixed lag: start a track, then push its measurements in
+    // time order. push returns true when it has filled `out` with the
+    // final smoothed state of the step `lag` behind; flush appends the
+    // steps still in the window.
+    void begin();
+    bool push(const Measurement& m, SmoothedPoint& out);
+    void flush(std::vector<SmoothedPoint>& out);
+
+    std::size_t lag() const { return cfg_.lag; }
+
+private:
+    // prev is the step before s, nullptr for the first of a track.
+    void forward(const Measurement& m, SmoothStep& s, SmoothStep* prev);
+    // Backward pass over the count steps at(0..count-1); emit(k, point)
+    // receives them newest first.
+    template <class Emit>
+    void backward(std::size_t count, Emit emit);
+
+    SmoothStep& at(std::size_t k) { return steps_[(head_ + k) % steps_.size()]; }
+
+    SmootherConfig cfg_;
+    KalmanFilter2D kf_;
+    double prev_time_{0.0};
+    bool started_{false};
+
+    std::vector<SmoothStep> steps_;  // all steps (batch) or a ring of lag + 1
+    std::size_t head_{0};
+    std::size_t count_{0};
+};
+
+// Smoothed trajectory of one track and its CPA timeline against own ship
+// (cpa.at(k) belongs to points[k]).
+struct SmoothedTrack
+{
+    std::vector<SmoothedPoint> points;
+    CpaResultBlock cpa;
+};
+
+// Smooth every track of the series on the pool, longest first, with one
+// reused smoother per worker thread; out[id] belongs to track id. The
+// result does not depend on the number of threads.
+void smooth_tracks(const TrackSeries& series,
+                   ThreadPool& pool,
+                   const Vec2& own_pos,
+                   const Vec2& own_vel,
+                   const SmootherConfig& cfg,
+                   std::vector<SmoothedTrack>& out);
@@ -0,0 +1,83 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// Bounded lock-free queue for exactly one producer thread and one consumer
+// thread.
+//
+// Slots are allocated once (capacity rounded up to a power of two). Each
+// side owns one index and keeps a cached copy of the other's, so the
+// shared cache lines are only touched when the cached view says the queue
+// looks full (producer) or empty (consumer). T should be trivially
+// copyable and small; slots are copied in and out.
+template <class T>
+class SpscQueue
+{
+public:
+    explicit SpscQueue(std::size_t capacity)
+    {
+        std::size_t size = 2;
+        while (size < capacity) size <<= 1;
+        slots_.resize(size);
+        mask_ = size - 1;
+    }
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // Producer only; false if the queue is full.
+    bool try_push(const T& v)
+    {
+        const std::size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_cache_ > mask_)
+        {
+            head_cache_ = head_.load(std::memory_order_acquire);
+            if (tail - head_cache_ > mask_) return false;
+        }
+        slots_[tail & mask_] = v;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only; false if the queue is empty.
+    bool try_pop(T& v)
+    {
+        return pop_n(&v, 1) == 1;
+    }
+
+    // Consumer only; moves up to max entries into out, returns how many.
+    std::size_t pop_n(T* out, std::size_t max)
+    {
+        const std::size_t head = head_.load(std::memory_order_relaxed);
+        if (tail_cache_ - head < max)
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+        std::size_t n = tail_cache_ - head;
+        if (n > max) n = max;
+        for (std::size_t k = 0; k < n; ++k) out[k] = slots_[(head + k) & mask_];
+        if (n) head_.store(head + n, std::memory_order_release);
+        return n;
+    }
+
+    // Entries waiting; exact on either side's thread, a snapshot elsewhere.
+    std::size_t size() const
+    {
+        const std::size_t head = head_.load(std::memory_order_acquire);
+        const std::size_t tail = tail_.load(std::memory_order_acquire);
+        return tail - head;
+    }
+
+    std::size_t capacity() const { return mask_ + 1; }
+
+private:
+    std::vector<T> slots_;
+    std::size_t mask_{0};
+
+    // consumer side
+    alignas(64) std::atomic<std::size_t> head_{0};
+    std::size_t tail_cache_{0};
+
+    // producer side
+    alignas(64) std::atomic<std::size_t> tail_{0};
+    std::size_t head_cache_{0};
+};
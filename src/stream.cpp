@@ -0,0 +1,505 @@
+#include "stream.h"
+#include "instrument.h"
+#include "json_writer.h"
+#include "metrics.h"
+#include "track_file.h"
+#include "udp_ingest.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+namespace
+{
+std::atomic<bool> g_stop{false};
+
+void on_sigint(int)
+{
+    g_stop = true;
+}
+
+void print_update(const std::string& name, const StreamTrack& trk)
+{
+    const CpaResult& r = trk.cpa;
+    std::cout << "t=" << trk.last_time
+              << " id=" << name
+              << " CPA=" << r.cpa_distance << "m"
+              << " TCPA=" << r.tcpa << "s "
+              << cpa_status_text(r) << "\n";
+}
+
+constexpr int N = KalmanFilter2D::N;
+
+void save_state(const KalmanFilter2D& kf, double time, ReplayEntry& e)
+{
+    e.prev_time = time;
+    std::copy(&kf.x[0], &kf.x[0] + N, e.x);
+    std::copy(&kf.P[0][0], &kf.P[0][0] + N * N, &e.P[0][0]);
+}
+
+void restore_state(const ReplayEntry& e, KalmanFilter2D& kf)
+{
+    std::copy(e.x, e.x + N, &kf.x[0]);
+    std::copy(&e.P[0][0], &e.P[0][0] + N * N, &kf.P[0][0]);
+}
+
+// Slot a measurement older than the track's last update into the ring and
+// re-filter everything after it. False if it predates the ring.
+bool insert_late(StreamTrack& trk, const MeasurementView& m, StreamStats& st)
+{
+    std::size_t i = 0;
+    while (i < trk.count && trk.at(i).time <= m.time) ++i;
+    if (i == trk.count) return false;
+    if (i == 0 && m.time < trk.at(0).prev_time) return false;
+
+    const double lag = trk.last_time - m.time;
+    st.late++;
+    st.replayed += trk.count - i;
+    st.total_lag += lag;
+    if (lag > st.max_lag) st.max_lag = lag;
+
+    // state just before the first update that is now out of order
+    restore_state(trk.at(i), trk.kf);
+    double t = trk.at(i).prev_time;
+
+    std::size_t from = 0;
+    if (trk.count < STREAM_REPLAY_DEPTH || i > 0)
+    {
+        if (trk.count == STREAM_REPLAY_DEPTH)
+        {
+            trk.head = (trk.head + 1) % STREAM_REPLAY_DEPTH;
+            --trk.count;
+            --i;
+        }
+        for (std::size_t k = trk.count; k > i; --k) trk.at(k) = trk.at(k - 1);
+        ++trk.count;
+
+        ReplayEntry& e = trk.at(i);
+        e.time = m.time;
+        e.zx = m.x;
+        e.zy = m.y;
+        from = i;
+    }
+    else
+    {
+        // full ring and older than all of it: apply, but it would be the
+        // first update evicted, so it is not buffered
+        trk.kf.predict(m.time - t);
+        trk.kf.update(m.x, m.y);
+        t = m.time;
+    }
+
+    for (std::size_t k = from; k < trk.count; ++k)
+    {
+        ReplayEntry& e = trk.at(k);
+        save_state(trk.kf, t, e);
+        trk.kf.predict(e.time - t);
+        trk.kf.update(e.zx, e.zy);
+        t = e.time;
+    }
+    return true;
+}
+
+// Updates between two metrics snapshots, and the longest wall time a
+// trickling feed may leave the published snapshot stale.
+constexpr std::size_t METRICS_PUBLISH_EVERY = 256;
+constexpr std::chrono::seconds METRICS_PUBLISH_INTERVAL{1};
+
+void publish_metrics(const StreamTracker& tracker, MetricsServer& metrics,
+                     std::size_t queue_depth = 0)
+{
+    const StreamStats& st = tracker.stats;
+    const TrackPoolStats& ps = tracker.tracks.stats();
+
+    MetricsSnapshot& s = metrics.snapshot();
+    s.updates = st.updates;
+    s.rejected_lines = st.rejected_lines;
+    s.late = st.late;
+    s.too_late = st.too_late;
+    s.replayed = st.replayed;
+    s.alerts = st.alerts;
+
+    s.live_tracks = ps.live;
+    s.capacity = ps.capacity;
+    s.created = ps.created;
+    s.expired = ps.expired;
+    s.evicted = ps.evicted;
+
+    s.risk = s.closing = s.valid = 0;
+    s.last_time = 0.0;
+    tracker.tracks.for_each([&s](const StreamTrack& trk)
+    {
+        s.risk += trk.cpa.collision_risk;
+        s.closing += trk.cpa.closing;
+        s.valid += trk.cpa.valid;
+        if (trk.last_time > s.last_time) s.last_time = trk.last_time;
+    });
+
+    s.queue_depth = queue_depth;
+    s.latency_mean_us = st.updates ? st.total_us / static_cast<double>(st.updates) : 0.0;
+    s.latency_max_us = st.max_us;
+
+    metrics.publish();
+}
+
+// Publishes a snapshot every METRICS_PUBLISH_EVERY updates, or on the next
+// row once METRICS_PUBLISH_INTERVAL has passed since the last one.
+class MetricsPacer
+{
+public:
+    explicit MetricsPacer(MetricsServer* metrics)
+        : metrics_(metrics), last_(std::chrono::steady_clock::now()) {}
+
+    // queue_depth() is only called when a snapshot is taken.
+    template <class F>
+    void tick(const StreamTracker& tracker, F queue_depth)
+    {
+        if (!metrics_) return;
+        const std::size_t updates = tracker.stats.updates;
+        if ((updates != published_ && updates % METRICS_PUBLISH_EVERY == 0) ||
+            std::chrono::steady_clock::now() - last_ >= METRICS_PUBLISH_INTERVAL)
+            publish(tracker, queue_depth());
+    }
+
+    void tick(const StreamTracker& tracker)
+    {
+        tick(tracker, [] { return std::size_t{0}; });
+    }
+
+    // Publish now unless nothing changed since the last snapshot.
+    void flush(const StreamTracker& tracker, std::size_t queue_depth = 0)
+    {
+        if (metrics_ && tracker.stats.updates != published_) publish(tracker, queue_depth);
+    }
+
+    void publish(const StreamTracker& tracker, std::size_t queue_depth = 0)
+    {
+        if (!metrics_) return;
+        publish_metrics(tracker, *metrics_, queue_depth);
+        published_ = tracker.stats.updates;
+        last_ = std::chrono::steady_clock::now();
+    }
+
+private:
+    MetricsServer* metrics_;
+    std::size_t published_{0};
+    std::chrono::steady_clock::time_point last_;
+};
+
+// Text line and / or NDJSON record for one update.
+void emit_update(const StreamTracker& tracker, const StreamTrack& trk, NdjsonWriter* ndjson)
+{
+    const std::string& name = tracker.tracks.name(tracker.tracks.slot(trk));
+    if (!ndjson || !ndjson->to_stdout())
+        print_update(name, trk);
+
+    if (ndjson)
+    {
+        ndjson->write_update(trk.last_time, name,
+                             Vec2{trk.kf.getX(),  trk.kf.getY()},
+                             Vec2{trk.kf.getVx(), trk.kf.getVy()},
+                             trk.cpa);
+    }
+}
+
+void print_stream_stats(const StreamTracker& tracker)
+{
+    const StreamStats& st = tracker.stats;
+    const TrackPoolStats& ps = tracker.tracks.stats();
+    double mean_us = st.updates ? st.total_us / static_cast<double>(st.updates) : 0.0;
+    double mean_lag = st.late ? st.total_lag / static_cast<double>(st.late) : 0.0;
+
+    std::cerr << std::fixed << std::setprecision(2)
+              << "=== Stream stats ===\n"
+              << "updates:        " << st.updates << "\n"
+              << "rejected lines: " << st.rejected_lines << "\n"
+              << "live tracks:    " << ps.live << " / " << ps.capacity
+              << " (peak " << ps.peak << ")\n"
+              << "tracks created: " << ps.created << "\n"
+              << "expired:        " << ps.expired << "\n"
+              << "evicted (full): " << ps.evicted << "\n"
+              << "risk alerts:    " << st.alerts << "\n"
+              << "latency mean:   " << mean_us << " us\n"
+              << "latency max:    " << st.max_us << " us\n"
+              << "late rows:      " << st.late << "\n"
+              << "too late:       " << st.too_late << "\n"
+              << "replayed steps: " << st.replayed << "\n"
+              << "reorder mean:   " << mean_lag << " s\n"
+              << "reorder max:    " << st.max_lag << " s\n";
+}
+}
+
+StreamTracker::StreamTracker(const Vec2& own_pos_, const Vec2& own_vel_,
+                             const StreamPoolConfig& pool)
+    : own_pos(own_pos_), own_vel(own_vel_), timeout(pool.timeout), tracks(pool.capacity)
+{
+}
+
+const StreamTrack* StreamTracker::process(const MeasurementView& m)
+{
+    CPA_TIMED_SCOPE(StreamUpdate);
+    auto t0 = std::chrono::steady_clock::now();
+
+    tracks.expire(m.time, timeout);
+
+    bool created = false;
+    StreamTrack& trk = tracks.acquire(m.id, created);
+    if (created)
+    {
+        Vec2 v0 = course_to_velocity(m.speed, m.course_deg);
+        trk.kf.init(m.x, m.y, v0.x, v0.y);
+        trk.last_time = m.time;
+    }
+
+    if (m.time >= trk.last_time)
+    {
+        if (trk.count == STREAM_REPLAY_DEPTH)
+        {
+            trk.head = (trk.head + 1) % STREAM_REPLAY_DEPTH;
+            --trk.count;
+        }
+        ReplayEntry& e = trk.at(trk.count++);
+        e.time = m.time;
+        e.zx = m.x;
+        e.zy = m.y;
+        save_state(trk.kf, trk.last_time, e);
+
+        trk.kf.predict(m.time - trk.last_time);
+        trk.kf.update(m.x, m.y);
+        trk.last_time = m.time;
+        tracks.touch(trk);
+    }
+    else if (!insert_late(trk, m, stats))
+    {
+        stats.too_late++;
+        return nullptr;
+    }
+
+    Vec2 filt_pos{trk.kf.getX(),  trk.kf.getY()};
+    Vec2 filt_vel{trk.kf.getVx(), trk.kf.getVy()};
+    const bool was_risk = trk.cpa.collision_risk;
+    trk.cpa = compute_cpa(own_pos, own_vel, filt_pos, filt_vel);
+    if (trk.cpa.collision_risk && !was_risk) stats.alerts++;
+
+    auto t1 = std::chrono::steady_clock::now();
+    double us = std::chrono::duration<double, std::micro>(t1 - t0).count();
+
+    stats.updates++;
+    stats.total_us += us;
+    if (us > stats.max_us) stats.max_us = us;
+
+    return &trk;
+}
+
+int run_stream(std::istream& in,
+               const Vec2& own_pos,
+               const Vec2& own_vel,
+               bool follow,
+               NdjsonWriter* ndjson,
+               const StreamPoolConfig& pool,
+               MetricsServer* metrics)
+{
+    StreamTracker tracker(own_pos, own_vel, pool);
+    MetricsPacer pacer(metrics);
+
+    auto prev_handler = std::signal(SIGINT, on_sigint);
+
+    std::cout << std::fixed << std::setprecision(1);
+
+    std::string line;
+    std::string partial;
+    bool header_seen = false;
+
+    while (!g_stop)
+    {
+        bool got = static_cast<bool>(std::getline(in, line));
+        if (got && follow && in.eof())
+        {
+            // unterminated tail: wait until the writer finishes the row
+            partial += line;
+            got = false;
+        }
+        if (!got)
+        {
+            if (!follow) break;
+            pacer.publish(tracker);
+            in.clear();
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            continue;
+        }
+
+        if (!partial.empty())
+        {
+            line = partial + line;
+            partial.clear();
+        }
+
+        if (!header_seen)
+        {
+            // we are waiting for the title: time,id,x,y,speed,course
+            header_seen = true;
+            continue;
+        }
+
+        if (line.empty()) continue;
+
+        MeasurementView m;
+        if (!parse_measurement_row(line, m))
+        {
+            tracker.stats.rejected_lines++;
+            continue;
+        }
+
+        const StreamTrack* trk = tracker.process(m);
+        pacer.tick(tracker);
+        if (!trk) continue;
+
+        emit_update(tracker, *trk, ndjson);
+        if (ndjson && follow) ndjson->flush();
+    }
+
+    std::cout.flush();
+    if (ndjson) ndjson->flush();
+    pacer.publish(tracker);
+    std::signal(SIGINT, prev_handler);
+
+    print_stream_stats(tracker);
+    return 0;
+}
+
+int run_stream(const TrackFile& file,
+               const Vec2& own_pos,
+               const Vec2& own_vel,
+               NdjsonWriter* ndjson,
+               const StreamPoolConfig& pool,
+               MetricsServer* metrics)
+{
+    StreamTracker tracker(own_pos, own_vel, pool);
+    MetricsPacer pacer(metrics);
+
+    auto prev_handler = std::signal(SIGINT, on_sigint);
+
+    std::cout << std::fixed << std::setprecision(1);
+
+    // k-way merge of the time-ordered blocks; ties go to the lower block
+    struct Head
+    {
+        double time;
+        std::size_t block;
+        std::size_t idx;
+    };
+    auto later = [](const Head& a, const Head& b)
+    {
+        return a.time != b.time ? a.time > b.time : a.block > b.block;
+    };
+    std::vector<Head> heap;
+    for (std::size_t i = 0; i < file.num_tracks(); ++i)
+        if (file.block(i).count) heap.push_back(Head{ file.block(i).time[0], i, 0 });
+    std::make_heap(heap.begin(), heap.end(), later);
+
+    while (!heap.empty() && !g_stop)
+    {
+        std::pop_heap(heap.begin(), heap.end(), later);
+        Head& h = heap.back();
+        const TrackBlock& b = file.block(h.block);
+        const std::size_t k = h.idx;
+
+        if (++h.idx < b.count)
+        {
+            h.time = b.time[h.idx];
+            std::push_heap(heap.begin(), heap.end(), later);
+        }
+        else
+        {
+            heap.pop_back();
+        }
+
+        MeasurementView m{ b.time[k], b.id, b.x[k], b.y[k], b.speed[k], b.course[k] };
+        const StreamTrack* trk = tracker.process(m);
+        pacer.tick(tracker);
+        if (!trk) continue;
+
+        emit_update(tracker, *trk, ndjson);
+    }
+
+    std::cout.flush();
+    if (ndjson) ndjson->flush();
+    pacer.publish(tracker);
+    std::signal(SIGINT, prev_handler);
+
+    print_stream_stats(tracker);
+    return 0;
+}
+
+int run_udp_stream(UdpReceiver& rx,
+                   const Vec2& own_pos,
+                   const Vec2& own_vel,
+                   NdjsonWriter* ndjson,
+                   const StreamPoolConfig& pool,
+                   MetricsServer* metrics)
+{
+    StreamTracker tracker(own_pos, own_vel, pool);
+    MetricsPacer pacer(metrics);
+    SpscQueue<ContactReport>& queue = rx.queue();
+
+    auto prev_handler = std::signal(SIGINT, on_sigint);
+
+    std::cout << std::fixed << std::setprecision(1);
+
+    constexpr std::size_t DRAIN = 256;
+    std::vector<ContactReport> batch(DRAIN);
+    std::size_t peak_depth = 0;
+
+    while (!g_stop)
+    {
+        const std::size_t depth = queue.size();
+        if (depth > peak_depth) peak_depth = depth;
+
+        std::size_t n = queue.pop_n(batch.data(), DRAIN);
+        if (n == 0)
+        {
+            pacer.flush(tracker);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+
+        for (std::size_t k = 0; k < n; ++k)
+        {
+            const StreamTrack* trk = tracker.process(batch[k].view());
+            pacer.tick(tracker, [&queue] { return queue.size(); });
+            if (!trk) continue;
+            emit_update(tracker, *trk, ndjson);
+        }
+
+        // hand each drained batch on at once, like --follow does per row
+        std::cout.flush();
+        if (ndjson) ndjson->flush();
+    }
+
+    pacer.publish(tracker);
+    std::signal(SIGINT, prev_handler);
+    rx.stop();
+
+    print_stream_stats(tracker);
+
+    const UdpIngestStats& is = rx.stats();
+    const std::uint64_t calls = is.receive_calls.load();
+    const double per_call = calls ? static_cast<double>(is.datagrams.load()) / static_cast<double>(calls) : 0.0;
+    std::cerr << "=== UDP ingest ===\n"
+              << "datagrams:      " << is.datagrams.load() << "\n"
+              << "sentences:      " << is.sentences.load() << "\n"
+              << "decoded:        " << is.decoded.load() << "\n"
+              << "bad checksum:   " << is.bad_checksum.load() << "\n"
+              << "unsupported:    " << is.unsupported.load() << "\n"
+              << "malformed:      " << is.malformed.load() << "\n"
+              << "AIS, no origin: " << is.no_origin.load() << "\n"
+              << "dropped (full): " << is.dropped.load() << "\n"
+              << "per receive:    " << per_call << " datagrams (max " << is.max_batch.load() << ")\n"
+              << "queue peak:     " << peak_depth << " / " << queue.capacity() << "\n";
+
+    return 0;
+}
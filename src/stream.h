@@ -0,0 +1,134 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <istream>
+#include <string>
+#include <vector>
+
+#include "kalman.h"
+#include "cpa.h"
+#include "io.h"
+#include "track_pool.h"
+
+class NdjsonWriter;
+class MetricsServer;
+class UdpReceiver;
+class TrackFile;
+
+// Updates kept per track for re-filtering late measurements.
+constexpr std::size_t STREAM_REPLAY_DEPTH = 16;
+
+// One buffered update: the measurement and the filter state just before
+// it was applied.
+struct ReplayEntry
+{
+    double time;
+    double zx, zy;
+    double prev_time;
+    double x[KalmanFilter2D::N];
+    double P[KalmanFilter2D::N][KalmanFilter2D::N];
+};
+
+// Live state of one track in streaming mode. The filter, the latest CPA
+// and a fixed ring of the last STREAM_REPLAY_DEPTH updates are kept in a
+// TrackPool slot, so memory is fixed by the pool capacity and does not
+// grow with the number of ids or the length of the recording.
+struct StreamTrack
+{
+    KalmanFilter2D kf;
+    double last_time{0.0};
+    CpaResult cpa;
+
+    // ring, oldest update at history[head]
+    std::array<ReplayEntry, STREAM_REPLAY_DEPTH> history;
+    std::size_t head{0};
+    std::size_t count{0};
+
+    ReplayEntry& at(std::size_t k) { return history[(head + k) % STREAM_REPLAY_DEPTH]; }
+};
+
+// Per-update latency (filter + CPA, replays included), in microseconds,
+// and out-of-order counters. Reorder lag is how far (in track time) a
+// late measurement was behind its track.
+struct StreamStats
+{
+    std::size_t updates{0};
+    std::size_t rejected_lines{0};
+    double total_us{0.0};
+    double max_us{0.0};
+
+    std::size_t late{0};          // slotted in by a replay
+    std::size_t too_late{0};      // older than the replay window, dropped
+    std::size_t replayed{0};      // updates re-applied after late ones
+    double total_lag{0.0};        // [s], over `late`
+    double max_lag{0.0};          // [s]
+
+    std::size_t alerts{0};        // updates that put a track into collision risk
+};
+
+// Track lifecycle in streaming mode.
+struct StreamPoolConfig
+{
+    std::size_t capacity{4096};  // live tracks at most
+    double timeout{60.0};        // [s] without updates before a track expires
+};
+
+struct StreamTracker
+{
+    Vec2 own_pos;
+    Vec2 own_vel;
+    double timeout;
+    TrackPool<StreamTrack> tracks;  // live tracks by id, slot = TrackId
+    StreamStats stats;
+
+    StreamTracker(const Vec2& own_pos_, const Vec2& own_vel_,
+                  const StreamPoolConfig& pool = StreamPoolConfig{});
+
+    // Feed one row; returns the track it updated. Tracks whose last update
+    // is more than `timeout` older than the row are expired first. A row
+    // older than its track's last update is inserted in time order: the
+    // filter is restored to the state before the next buffered update and
+    // the rest of the ring is re-applied (at most STREAM_REPLAY_DEPTH
+    // steps). Such rows leave last_time, and so the track's place in the
+    // pool, unchanged. Returns nullptr if the row is older than everything
+    // still buffered.
+    const StreamTrack* process(const MeasurementView& m);
+};
+
+// Read "time,id,x,y,speed,course" rows from `in` one at a time (first line
+// is the header) and print an updated CPA/TCPA line for every measurement.
+// With follow = true the reader keeps polling at EOF, like `tail -f`,
+// until interrupted. Latency statistics go to stderr at the end.
+// If ndjson is given, every update is also written there as one record
+// (flushed per record when following); the text lines are left out when
+// the records go to stdout. Track slots come from a pool sized by `pool`.
+// If metrics is given, a snapshot of the counters is published to it every
+// few hundred updates or on the first row after a second without one,
+// whenever the follower waits for input, and at the end.
+int run_stream(std::istream& in,
+               const Vec2& own_pos,
+               const Vec2& own_vel,
+               bool follow,
+               NdjsonWriter* ndjson = nullptr,
+               const StreamPoolConfig& pool = StreamPoolConfig{},
+               MetricsServer* metrics = nullptr);
+
+// Same tracking loop over a mapped track file: the rows of all blocks are
+// merged into time order (ties by block) and fed to the tracker in place.
+int run_stream(const TrackFile& file,
+               const Vec2& own_pos,
+               const Vec2& own_vel,
+               NdjsonWriter* ndjson = nullptr,
+               const StreamPoolConfig& pool = StreamPoolConfig{},
+               MetricsServer* metrics = nullptr);
+
+// Same tracking loop fed by a started UdpReceiver instead of a CSV reader:
+// decoded NMEA reports are drained from its queue in batches until SIGINT,
+// then the receiver is stopped and its counters are printed with the
+// stream stats. The metrics snapshot also carries the queue depth.
+int run_udp_stream(UdpReceiver& rx,
+                   const Vec2& own_pos,
+                   const Vec2& own_vel,
+                   NdjsonWriter* ndjson = nullptr,
+                   const StreamPoolConfig& pool = StreamPoolConfig{},
+                   MetricsServer* metrics = nullptr);
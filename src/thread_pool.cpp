@@ -0,0 +1,152 @@
+#include "thread_pool.h"
+
+namespace
+{
+inline std::uint64_t pack(std::uint32_t b, std::uint32_t e)
+{
+    return (static_cast<std::uint64_t>(b) << 32) | e;
+}
+inline std::uint32_t range_begin(std::uint64_t r) { return static_cast<std::uint32_t>(r >> 32); }
+inline std::uint32_t range_end(std::uint64_t r)   { return static_cast<std::uint32_t>(r); }
+}
+
+ThreadPool::ThreadPool(unsigned threads)
+{
+    if (threads == 0) threads = std::thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+    num_threads_ = threads;
+    blocks_.reset(new Block[threads]);
+
+    for (unsigned w = 1; w < threads; ++w)
+        workers_.emplace_back(&ThreadPool::worker_main, this, w);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    start_cv_.notify_all();
+    for (auto& t : workers_) t.join();
+}
+
+void ThreadPool::parallel_for(std::size_t count, const std::function<void(std::size_t)>& fn)
+{
+    if (count == 0) return;
+
+    if (num_threads_ == 1 || count == 1)
+    {
+        for (std::size_t i = 0; i < count; ++i) fn(i);
+        return;
+    }
+
+    // indices are packed into 32 bits per bound
+    if (count > 0xFFFFFFFFull)
+    {
+        for (std::size_t i = 0; i < count; ++i) fn(i);
+        return;
+    }
+
+    const std::size_t per = count / num_threads_;
+    const std::size_t rem = count % num_threads_;
+    std::size_t begin = 0;
+    for (unsigned w = 0; w < num_threads_; ++w)
+    {
+        std::size_t len = per + (w < rem ? 1 : 0);
+        blocks_[w].range.store(pack(static_cast<std::uint32_t>(begin),
+                                    static_cast<std::uint32_t>(begin + len)),
+                               std::memory_order_relaxed);
+        begin += len;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        job_ = &fn;
+        busy_ = num_threads_ - 1;
+        ++generation_;
+    }
+    start_cv_.notify_all();
+
+    run_blocks(0);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_cv_.wait(lock, [&]{ return busy_ == 0; });
+    job_ = nullptr;
+}
+
+void ThreadPool::worker_main(unsigned w)
+{
+    std::uint64_t seen = 0;
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            start_cv_.wait(lock, [&]{ return stop_ || generation_ != seen; });
+            if (stop_) return;
+            seen = generation_;
+        }
+
+        run_blocks(w);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            --busy_;
+        }
+        done_cv_.notify_one();
+    }
+}
+
+void ThreadPool::run_blocks(unsigned w)
+{
+    const auto& fn = *job_;
+    std::size_t idx;
+    for (;;)
+    {
+        if (pop(w, idx) || steal(w, idx))
+            fn(idx);
+        else
+            return;
+    }
+}
+
+bool ThreadPool::pop(unsigned w, std::size_t& idx)
+{
+    auto& range = blocks_[w].range;
+    std::uint64_t r = range.load(std::memory_order_acquire);
+    for (;;)
+    {
+        std::uint32_t b = range_begin(r), e = range_end(r);
+        if (b >= e) return false;
+        if (range.compare_exchange_weak(r, pack(b + 1, e), std::memory_order_acq_rel))
+        {
+            idx = b;
+            return true;
+        }
+    }
+}
+
+bool ThreadPool::steal(unsigned w, std::size_t& idx)
+{
+    for (unsigned k = 1; k < num_threads_; ++k)
+    {
+        auto& victim = blocks_[(w + k) % num_threads_].range;
+        std::uint64_t r = victim.load(std::memory_order_acquire);
+        for (;;)
+        {
+            std::uint32_t b = range_begin(r), e = range_end(r);
+            if (b >= e) break;
+
+            // take the back half, run its first index now and keep the rest
+            std::uint32_t take = (e - b + 1) / 2;
+            std::uint32_t mid  = e - take;
+            if (victim.compare_exchange_weak(r, pack(b, mid), std::memory_order_acq_rel))
+            {
+                blocks_[w].range.store(pack(mid + 1, e), std::memory_order_release);
+                idx = mid;
+                return true;
+            }
+        }
+    }
+    return false;
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads running index-parallel loops.
+//
+// parallel_for splits [0, count) into one contiguous block per thread.
+// Each thread pops indices from the front of its own block; when it runs
+// dry it steals the back half of another thread's block. Blocks are packed
+// [begin, end) pairs in one atomic word, so popping and stealing are single
+// CAS operations. Suited for skewed per-index cost (e.g. track lengths).
+// The calling thread takes part as worker 0.
+class ThreadPool
+{
+public:
+    // threads == 0 uses std::thread::hardware_concurrency().
+    explicit ThreadPool(unsigned threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned size() const { return num_threads_; }
+
+    // Run fn(i) for every i in [0, count) and wait for completion.
+    // Must not be called from inside fn.
+    void parallel_for(std::size_t count, const std::function<void(std::size_t)>& fn);
+
+private:
+    struct alignas(64) Block
+    {
+        std::atomic<std::uint64_t> range{0};
+    };
+
+    void worker_main(unsigned w);
+    void run_blocks(unsigned w);
+    bool pop(unsigned w, std::size_t& idx);
+    bool steal(unsigned w, std::size_t& idx);
+
+    unsigned num_threads_{1};
+    std::unique_ptr<Block[]> blocks_;
+    std::vector<std::thread> workers_;
+
+    std::mutex mutex_;
+    std::condition_variable start_cv_;
+    std::condition_variable done_cv_;
+    std::uint64_t generation_{0};
+    unsigned busy_{0};
+    bool stop_{false};
+    const std::function<void(std::size_t)>* job_{nullptr};
+};
@@ -0,0 +1,229 @@
+#include "track_file.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace
+{
+inline std::uint64_t align8(std::uint64_t v)
+{
+    return (v + 7) & ~std::uint64_t{7};
+}
+}
+
+bool is_track_file(const std::string& path)
+{
+    // a pipe would lose the bytes read here; track files are always seekable
+    std::error_code ec;
+    if (!std::filesystem::is_regular_file(path, ec)) return false;
+
+    std::ifstream file(path, std::ios::binary);
+    char magic[sizeof(TRACK_FILE_MAGIC)] = {};
+    if (!file.read(magic, sizeof(magic))) return false;
+    return std::memcmp(magic, TRACK_FILE_MAGIC, sizeof(magic)) == 0;
+}
+
+bool TrackFile::open(const std::string& path)
+{
+    blocks_.clear();
+    num_rows_ = 0;
+
+    if (!file_.open(path))
+    {
+        std::cerr << "Failed to open file: " << path << "\n";
+        return false;
+    }
+
+    const char* base = file_.data();
+    const std::uint64_t size = file_.size();
+
+    TrackFileHeader hdr;
+    if (size < sizeof(hdr))
+    {
+        std::cerr << "Track file too small: " << path << "\n";
+        return false;
+    }
+    std::memcpy(&hdr, base, sizeof(hdr));
+
+    if (std::memcmp(hdr.magic, TRACK_FILE_MAGIC, sizeof(hdr.magic)) != 0)
+    {
+        std::cerr << "Not a track file: " << path << "\n";
+        return false;
+    }
+    if (hdr.version != TRACK_FILE_VERSION || hdr.endian_mark != TRACK_FILE_ENDIAN_MARK)
+    {
+        std::cerr << "Unsupported track file version or byte order: " << path << "\n";
+        return false;
+    }
+
+    const std::uint64_t n = hdr.num_tracks;
+    if (hdr.index_offset % 8 != 0 || hdr.index_offset > size ||
+        n > (size - hdr.index_offset) / sizeof(TrackBlockEntry))
+    {
+        std::cerr << "Corrupt track index: " << path << "\n";
+        return false;
+    }
+
+    if (hdr.dict_offset % 8 != 0 || hdr.dict_offset > size)
+    {
+        std::cerr << "Corrupt track dictionary: " << path << "\n";
+        return false;
+    }
+
+    const auto* index = reinterpret_cast<const TrackBlockEntry*>(base + hdr.index_offset);
+
+    blocks_.resize(n);
+    // pos <= size holds throughout, so size - pos cannot wrap
+    std::uint64_t pos = hdr.dict_offset;
+    for (std::uint64_t i = 0; i < n; ++i)
+    {
+        std::uint32_t len;
+        if (sizeof(len) > size - pos)
+        {
+            std::cerr << "Corrupt track dictionary: " << path << "\n";
+            return false;
+        }
+        std::memcpy(&len, base + pos, sizeof(len));
+        pos += sizeof(len);
+        if (len > size - pos)
+        {
+            std::cerr << "Corrupt track dictionary: " << path << "\n";
+            return false;
+        }
+
+        TrackBlock& b = blocks_[i];
+        b.id = std::string_view(base + pos, len);
+        pos = std::min(align8(pos + len), size);
+
+        const TrackBlockEntry& e = index[i];
+        if (e.offset % 8 != 0 || e.offset > size ||
+            e.count > (size - e.offset) / (5 * sizeof(double)))
+        {
+            std::cerr << "Corrupt track block " << i << ": " << path << "\n";
+            return false;
+        }
+
+        const auto* col = reinterpret_cast<const double*>(base + e.offset);
+        b.count  = static_cast<std::size_t>(e.count);
+        b.time   = col;
+        b.x      = col + b.count;
+        b.y      = col + 2 * b.count;
+        b.speed  = col + 3 * b.count;
+        b.course = col + 4 * b.count;
+
+        num_rows_ += b.count;
+    }
+
+    return true;
+}
+
+bool write_track_file(const std::string& path, const TrackSeries& series)
+{
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out)
+    {
+        std::cerr << "Failed to open track file for writing: " << path << "\n";
+        return false;
+    }
+
+    TrackFileHeader hdr{};
+    std::memcpy(hdr.magic, TRACK_FILE_MAGIC, sizeof(hdr.magic));
+    hdr.version     = TRACK_FILE_VERSION;
+    hdr.endian_mark = TRACK_FILE_ENDIAN_MARK;
+    hdr.num_tracks  = series.size();
+    hdr.dict_offset = align8(sizeof(hdr));
+
+    std::uint64_t pos = hdr.dict_offset;
+    for (TrackId id = 0; id < series.size(); ++id)
+    {
+        pos = align8(pos + sizeof(std::uint32_t) + series.ids.name(id).size());
+        hdr.num_rows += series.series[id].size();
+    }
+    hdr.index_offset = pos;
+    pos += series.size() * sizeof(TrackBlockEntry);
+
+    std::vector<TrackBlockEntry> index;
+    index.reserve(series.size());
+    for (const auto& seq : series.series)
+    {
+        index.push_back(TrackBlockEntry{ pos, seq.size() });
+        pos += 5 * sizeof(double) * seq.size();
+    }
+
+    const char zeros[8] = {};
+    auto pad_to = [&](std::uint64_t target)
+    {
+        std::uint64_t cur = static_cast<std::uint64_t>(out.tellp());
+        if (target > cur) out.write(zeros, static_cast<std::streamsize>(target - cur));
+    };
+
+    out.write(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+    pad_to(hdr.dict_offset);
+
+    for (TrackId id = 0; id < series.size(); ++id)
+    {
+        const std::string& name = series.ids.name(id);
+        std::uint32_t len = static_cast<std::uint32_t>(name.size());
+        out.write(reinterpret_cast<const char*>(&len), sizeof(len));
+        out.write(name.data(), len);
+        pad_to(align8(static_cast<std::uint64_t>(out.tellp())));
+    }
+
+    out.write(reinterpret_cast<const char*>(index.data()),
+              static_cast<std::streamsize>(index.size() * sizeof(TrackBlockEntry)));
+
+    std::vector<double> col;
+    for (const auto& seq : series.series)
+    {
+        col.resize(seq.size());
+        for (double Measurement::* field : { &Measurement::time, &Measurement::x, &Measurement::y,
+                                             &Measurement::speed, &Measurement::course_deg })
+        {
+            for (std::size_t i = 0; i < seq.size(); ++i) col[i] = seq[i].*field;
+            out.write(reinterpret_cast<const char*>(col.data()),
+                      static_cast<std::streamsize>(col.size() * sizeof(double)));
+        }
+    }
+
+    if (!out)
+    {
+        std::cerr << "Write error: " << path << "\n";
+        return false;
+    }
+    return true;
+}
+
+bool load_track_file(const std::string& path, TrackSeries& out)
+{
+    TrackFile tf;
+    if (!tf.open(path)) return false;
+
+    for (std::size_t i = 0; i < tf.num_tracks(); ++i)
+    {
+        const TrackBlock& b = tf.block(i);
+        auto& seq = out.track(b.id);
+        TrackId id = out.ids.intern(b.id);
+
+        seq.reserve(seq.size() + b.count);
+        for (std::size_t k = 0; k < b.count; ++k)
+            seq.push_back(Measurement{ b.time[k], id, b.x[k], b.y[k], b.speed[k], b.course[k] });
+    }
+
+    out.sort_by_name();
+    return true;
+}
+
+bool track_file_ids(const TrackFile& file, TrackIdTable& ids)
+{
+    ids = TrackIdTable{};
+    for (std::size_t i = 0; i < file.num_tracks(); ++i)
+    {
+        std::string_view id = file.block(i).id;
+        if (i > 0 && !(file.block(i - 1).id < id)) return false;
+        ids.intern(id);
+    }
+    return true;
+}
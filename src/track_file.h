@@ -0,0 +1,86 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "io.h"
+#include "mapped_file.h"
+
+// Binary columnar track format (".cpatrk").
+//
+//   header      TrackFileHeader
+//   dictionary  per track: uint32 length + id bytes, padded to 8 bytes
+//   index       per track: TrackBlockEntry
+//   blocks      per track: time[n], x[n], y[n], speed[n], course[n] (double)
+//
+// All offsets are from the start of the file and 8-byte aligned, so a
+// mapped file is read in place. Values are stored in host byte order; the
+// header records it and the reader rejects files from the other order.
+// Blocks are time-ordered, as produced by load_timeseries_from_csv.
+
+constexpr char TRACK_FILE_MAGIC[8] = { 'C', 'P', 'A', 'T', 'R', 'K', '0', '1' };
+constexpr std::uint32_t TRACK_FILE_VERSION = 1;
+constexpr std::uint32_t TRACK_FILE_ENDIAN_MARK = 0x01020304u;
+
+struct TrackFileHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t endian_mark;
+    std::uint64_t num_tracks;
+    std::uint64_t num_rows;
+    std::uint64_t dict_offset;
+    std::uint64_t index_offset;
+};
+
+struct TrackBlockEntry
+{
+    std::uint64_t offset;   // start of the time column
+    std::uint64_t count;    // samples in the block
+};
+
+// Column pointers of one track, valid while the TrackFile stays open.
+struct TrackBlock
+{
+    std::string_view id;
+    std::size_t count{0};
+    const double* time{nullptr};
+    const double* x{nullptr};
+    const double* y{nullptr};
+    const double* speed{nullptr};
+    const double* course{nullptr};
+};
+
+// Memory-mapped, validated track file.
+class TrackFile
+{
+public:
+    // Reports problems to stderr and returns false.
+    bool open(const std::string& path);
+
+    std::size_t num_tracks() const { return blocks_.size(); }
+    std::size_t num_rows() const { return num_rows_; }
+    const TrackBlock& block(std::size_t i) const { return blocks_[i]; }
+
+private:
+    MappedFile file_;
+    std::vector<TrackBlock> blocks_;
+    std::size_t num_rows_{0};
+};
+
+// True if path is a regular file that starts with the track file magic.
+bool is_track_file(const std::string& path);
+
+// Write all tracks as a track file, in TrackId order.
+bool write_track_file(const std::string& path, const TrackSeries& series);
+
+// Ids of the blocks numbered by block index, as load_track_file would number
+// them, so results of filter_tracks(TrackFile) line up with the ids. False
+// (ids left partial) if the blocks are not unique and in name order; files
+// written by write_track_file always are.
+bool track_file_ids(const TrackFile& file, TrackIdTable& ids);
+
+// Read a track file into the same container load_timeseries_from_csv fills.
+bool load_track_file(const std::string& path, TrackSeries& out);
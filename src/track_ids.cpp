@@ -0,0 +1,60 @@
+#include "track_ids.h"
+
+#include <algorithm>
+#include <numeric>
+
+TrackIdTable::TrackIdTable(const TrackIdTable& other)
+{
+    *this = other;
+}
+
+TrackIdTable& TrackIdTable::operator=(const TrackIdTable& other)
+{
+    if (this == &other) return *this;
+    storage_.clear();
+    names_.clear();
+    index_.clear();
+    for (const std::string* n : other.names_) intern(*n);
+    return *this;
+}
+
+TrackId TrackIdTable::intern(std::string_view name)
+{
+    auto it = index_.find(name);
+    if (it != index_.end()) return it->second;
+
+    storage_.emplace_back(name);
+    const std::string& stored = storage_.back();
+    TrackId id = static_cast<TrackId>(names_.size());
+    names_.push_back(&stored);
+    index_.emplace(std::string_view(stored), id);
+    return id;
+}
+
+bool TrackIdTable::find(std::string_view name, TrackId& id) const
+{
+    auto it = index_.find(name);
+    if (it == index_.end()) return false;
+    id = it->second;
+    return true;
+}
+
+void TrackIdTable::sort_by_name(std::vector<TrackId>& remap)
+{
+    std::vector<TrackId> order(names_.size());
+    std::iota(order.begin(), order.end(), TrackId{0});
+    std::sort(order.begin(), order.end(),
+              [&](TrackId a, TrackId b){ return *names_[a] < *names_[b]; });
+
+    remap.assign(names_.size(), 0);
+    std::vector<const std::string*> sorted(names_.size());
+    for (std::size_t k = 0; k < order.size(); ++k)
+    {
+        remap[order[k]] = static_cast<TrackId>(k);
+        sorted[k] = names_[order[k]];
+    }
+
+    names_.swap(sorted);
+    for (std::size_t k = 0; k < names_.size(); ++k)
+        index_[std::string_view(*names_[k])] = static_cast<TrackId>(k);
+}
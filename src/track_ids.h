@@ -0,0 +1,41 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Dense index of a track; what Measurement and all per-track arrays use.
+using TrackId = std::uint32_t;
+
+// Maps external id strings to dense TrackIds (0, 1, 2, ... in order of
+// first appearance). Names are stored once; lookups take a string_view
+// and do not allocate.
+class TrackIdTable
+{
+public:
+    TrackIdTable() = default;
+    TrackIdTable(const TrackIdTable& other);
+    TrackIdTable& operator=(const TrackIdTable& other);
+    TrackIdTable(TrackIdTable&&) = default;
+    TrackIdTable& operator=(TrackIdTable&&) = default;
+
+    // Existing id for name, or a new one.
+    TrackId intern(std::string_view name);
+
+    // False if name has not been interned.
+    bool find(std::string_view name, TrackId& id) const;
+
+    const std::string& name(TrackId id) const { return *names_[id]; }
+    std::size_t size() const { return names_.size(); }
+
+    // Renumber so that ids follow lexicographic name order.
+    // remap[old] receives the new id.
+    void sort_by_name(std::vector<TrackId>& remap);
+
+private:
+    std::deque<std::string> storage_;
+    std::vector<const std::string*> names_;
+    std::unordered_map<std::string_view, TrackId> index_;
+};
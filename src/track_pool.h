@@ -0,0 +1,233 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "track_ids.h"
+
+struct TrackPoolStats
+{
+    std::size_t capacity{0};
+    std::size_t live{0};       // occupied slots
+    std::size_t peak{0};       // highest occupancy seen
+    std::size_t created{0};    // names given a slot
+    std::size_t expired{0};    // released after the timeout
+    std::size_t evicted{0};    // released to make room when full
+};
+
+// Fixed-capacity storage for live tracks of type T (which needs a
+// `double last_time`), keyed by external name.
+//
+// All slots, the name index (open addressing, linear probing with
+// backward-shift deletion) and an intrusive list ordering the slots by
+// last_time are allocated in the constructor. Released slots go back on a free
+// list and are reset to T{} when reused, so a long-running tracker does
+// not grow or fragment the heap; only names longer than the string's
+// small buffer allocate, and a slot keeps that capacity for later names.
+// A track's slot number is its TrackId while it lives.
+template <class T>
+class TrackPool
+{
+public:
+    explicit TrackPool(std::size_t capacity);
+
+    TrackPool(const TrackPool&) = delete;
+    TrackPool& operator=(const TrackPool&) = delete;
+
+    // Track for name. A new name gets a fresh slot (created = true) at the
+    // newest end; when all slots are live the track with the oldest
+    // last_time is evicted for it. An existing track keeps its place.
+    T& acquire(std::string_view name, bool& created);
+
+    // Move t to its place after its last_time changed. The list is walked
+    // from the newest end, so in-order feeds cost O(1).
+    void touch(const T& t);
+
+    // nullptr if name has no live track.
+    T* find(std::string_view name);
+
+    // Release tracks whose last_time is before now - timeout, oldest
+    // first; returns how many were released.
+    std::size_t expire(double now, double timeout);
+
+    // Visit every live track, oldest last_time first.
+    template <class F>
+    void for_each(F f) const
+    {
+        for (std::uint32_t s = head_; s != none; s = next_[s]) f(slots_[s]);
+    }
+
+    TrackId slot(const T& t) const { return static_cast<TrackId>(&t - slots_.data()); }
+    const std::string& name(TrackId slot) const { return names_[slot]; }
+    const TrackPoolStats& stats() const { return stats_; }
+
+private:
+    static constexpr std::uint32_t none = 0xffffffffu;
+
+    std::size_t probe(std::string_view name, std::size_t h) const;
+    void release(std::uint32_t s);
+    void unlink(std::uint32_t s);
+    void push_back(std::uint32_t s);
+
+    std::vector<T> slots_;
+    std::vector<std::string> names_;
+    std::vector<std::size_t> hashes_;
+    std::vector<std::uint32_t> free_;
+
+    // doubly linked by last_time, head_ is the oldest
+    std::vector<std::uint32_t> prev_, next_;
+    std::uint32_t head_{none}, tail_{none};
+
+    std::vector<std::uint32_t> table_;  // slot or none
+    std::size_t mask_{0};
+
+    TrackPoolStats stats_;
+};
+
+template <class T>
+TrackPool<T>::TrackPool(std::size_t capacity)
+{
+    if (capacity == 0) capacity = 1;
+    slots_.resize(capacity);
+    names_.resize(capacity);
+    hashes_.resize(capacity);
+    prev_.assign(capacity, none);
+    next_.assign(capacity, none);
+
+    free_.reserve(capacity);
+    for (std::size_t s = capacity; s-- > 0; )
+        free_.push_back(static_cast<std::uint32_t>(s));
+
+    std::size_t size = 1;
+    while (size < 2 * capacity) size <<= 1;
+    table_.assign(size, none);
+    mask_ = size - 1;
+
+    stats_.capacity = capacity;
+}
+
+template <class T>
+std::size_t TrackPool<T>::probe(std::string_view name, std::size_t h) const
+{
+    std::size_t i = h & mask_;
+    while (table_[i] != none)
+    {
+        const std::uint32_t s = table_[i];
+        if (hashes_[s] == h && names_[s] == name) break;
+        i = (i + 1) & mask_;
+    }
+    return i;
+}
+
+template <class T>
+T* TrackPool<T>::find(std::string_view name)
+{
+    std::size_t i = probe(name, std::hash<std::string_view>{}(name));
+    return table_[i] == none ? nullptr : &slots_[table_[i]];
+}
+
+template <class T>
+T& TrackPool<T>::acquire(std::string_view name, bool& created)
+{
+    const std::size_t h = std::hash<std::string_view>{}(name);
+    std::size_t i = probe(name, h);
+
+    if (table_[i] != none)
+    {
+        created = false;
+        return slots_[table_[i]];
+    }
+
+    if (free_.empty())
+    {
+        release(head_);
+        ++stats_.evicted;
+        i = probe(name, h);  // the table has shifted
+    }
+
+    const std::uint32_t s = free_.back();
+    free_.pop_back();
+
+    slots_[s] = T{};
+    names_[s].assign(name.data(), name.size());
+    hashes_[s] = h;
+    table_[i] = s;
+    push_back(s);
+
+    ++stats_.created;
+    if (++stats_.live > stats_.peak) stats_.peak = stats_.live;
+    created = true;
+    return slots_[s];
+}
+
+template <class T>
+void TrackPool<T>::touch(const T& t)
+{
+    const std::uint32_t s = static_cast<std::uint32_t>(slot(t));
+    std::uint32_t p = prev_[s];
+    if (next_[s] == none && (p == none || slots_[p].last_time <= t.last_time)) return;
+
+    unlink(s);
+    p = tail_;
+    while (p != none && slots_[p].last_time > t.last_time) p = prev_[p];
+
+    // insert after p (at the head if none)
+    prev_[s] = p;
+    next_[s] = (p == none) ? head_ : next_[p];
+    if (next_[s] != none) prev_[next_[s]] = s; else tail_ = s;
+    if (p != none) next_[p] = s; else head_ = s;
+}
+
+template <class T>
+std::size_t TrackPool<T>::expire(double now, double timeout)
+{
+    std::size_t n = 0;
+    while (head_ != none && slots_[head_].last_time < now - timeout)
+    {
+        release(head_);
+        ++n;
+    }
+    stats_.expired += n;
+    return n;
+}
+
+template <class T>
+void TrackPool<T>::release(std::uint32_t s)
+{
+    // backward-shift delete from the index
+    std::size_t i = probe(names_[s], hashes_[s]);
+    table_[i] = none;
+    for (std::size_t j = (i + 1) & mask_; table_[j] != none; j = (j + 1) & mask_)
+    {
+        const std::size_t k = hashes_[table_[j]] & mask_;  // home of entry j
+        const bool stays = (i <= j) ? (i < k && k <= j) : (i < k || k <= j);
+        if (stays) continue;
+        table_[i] = table_[j];
+        table_[j] = none;
+        i = j;
+    }
+
+    unlink(s);
+    free_.push_back(s);
+    --stats_.live;
+}
+
+template <class T>
+void TrackPool<T>::unlink(std::uint32_t s)
+{
+    if (prev_[s] != none) next_[prev_[s]] = next_[s]; else head_ = next_[s];
+    if (next_[s] != none) prev_[next_[s]] = prev_[s]; else tail_ = prev_[s];
+    prev_[s] = next_[s] = none;
+}
+
+template <class T>
+void TrackPool<T>::push_back(std::uint32_t s)
+{
+    prev_[s] = tail_;
+    next_[s] = none;
+    if (tail_ != none) next_[tail_] = s; else head_ = s;
+    tail_ = s;
+}
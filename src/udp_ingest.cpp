@@ -0,0 +1,197 @@
+#include "udp_ingest.h"
+
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#define CPA_HAVE_SOCKETS 1
+#endif
+
+namespace
+{
+// Largest datagram kept; a multiplexer may pack several sentences into one.
+constexpr std::size_t DATAGRAM_BYTES = 8192;
+
+void bump_max(std::atomic<std::uint64_t>& m, std::uint64_t v)
+{
+    if (v > m.load(std::memory_order_relaxed)) m.store(v, std::memory_order_relaxed);
+}
+}
+
+UdpReceiver::UdpReceiver(const UdpIngestConfig& cfg)
+    : cfg_(cfg), queue_(cfg.queue_capacity)
+{
+    if (cfg_.batch == 0) cfg_.batch = 1;
+    if (cfg_.has_origin) decoder_.set_origin(cfg_.origin_lat, cfg_.origin_lon);
+}
+
+UdpReceiver::~UdpReceiver()
+{
+    stop();
+}
+
+void UdpReceiver::handle_datagram(const char* data, std::size_t len, double recv_time)
+{
+    stats_.datagrams.fetch_add(1, std::memory_order_relaxed);
+
+    std::string_view rest(data, len);
+    while (!rest.empty())
+    {
+        std::size_t eol = rest.find('\n');
+        std::string_view line = rest.substr(0, eol);
+        rest = (eol == std::string_view::npos) ? std::string_view() : rest.substr(eol + 1);
+        while (!line.empty() && (line.back() == '\r' || line.back() == ' ')) line.remove_suffix(1);
+        if (line.empty()) continue;
+
+        stats_.sentences.fetch_add(1, std::memory_order_relaxed);
+
+        ContactReport r;
+        switch (decoder_.decode(line, recv_time, r))
+        {
+            case NmeaStatus::Ok:
+                if (queue_.try_push(r))
+                    stats_.decoded.fetch_add(1, std::memory_order_relaxed);
+                else
+                    stats_.dropped.fetch_add(1, std::memory_order_relaxed);
+                break;
+            case NmeaStatus::BadChecksum:
+                stats_.bad_checksum.fetch_add(1, std::memory_order_relaxed);
+                break;
+            case NmeaStatus::Unsupported:
+            case NmeaStatus::NoPosition:
+                stats_.unsupported.fetch_add(1, std::memory_order_relaxed);
+                break;
+            case NmeaStatus::Malformed:
+                stats_.malformed.fetch_add(1, std::memory_order_relaxed);
+                break;
+            case NmeaStatus::NoOrigin:
+                stats_.no_origin.fetch_add(1, std::memory_order_relaxed);
+                break;
+        }
+    }
+}
+
+#ifdef CPA_HAVE_SOCKETS
+
+bool UdpReceiver::start()
+{
+    fd_ = ::socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd_ < 0)
+    {
+        std::cerr << "udp: socket: " << std::strerror(errno) << "\n";
+        return false;
+    }
+    int one = 1;
+    ::setsockopt(fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    // absorb bursts while the receiver thread is descheduled
+    int rcvbuf = 4 << 20;
+    ::setsockopt(fd_, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(cfg_.port);
+    if (::bind(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0)
+    {
+        std::cerr << "udp: cannot bind port " << cfg_.port << ": " << std::strerror(errno) << "\n";
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+
+    socklen_t len = sizeof(addr);
+    ::getsockname(fd_, reinterpret_cast<sockaddr*>(&addr), &len);
+    port_ = ntohs(addr.sin_port);
+
+    // receive times count on from this midnight, past 86400 if need be
+    midnight_ = std::floor(utc_seconds() / 86400.0) * 86400.0;
+
+    stop_ = false;
+    thread_ = std::thread(&UdpReceiver::run, this);
+    return true;
+}
+
+void UdpReceiver::stop()
+{
+    stop_ = true;
+    if (thread_.joinable()) thread_.join();
+    if (fd_ >= 0)
+    {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+void UdpReceiver::run()
+{
+    const std::size_t batch = cfg_.batch;
+    std::vector<char> buf(batch * DATAGRAM_BYTES);
+
+#ifdef __linux__
+    std::vector<iovec> iov(batch);
+    std::vector<mmsghdr> msgs(batch);
+    for (std::size_t i = 0; i < batch; ++i)
+    {
+        iov[i].iov_base = buf.data() + i * DATAGRAM_BYTES;
+        iov[i].iov_len = DATAGRAM_BYTES;
+        msgs[i] = mmsghdr{};
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+#endif
+
+    while (!stop_)
+    {
+        pollfd p{ fd_, POLLIN, 0 };
+        if (::poll(&p, 1, 200) <= 0) continue;  // wake up to check stop_
+
+        const double now = utc_seconds() - midnight_;
+        std::size_t got = 0;
+
+#ifdef __linux__
+        int n = ::recvmmsg(fd_, msgs.data(), static_cast<unsigned>(batch), MSG_DONTWAIT, nullptr);
+        if (n <= 0) continue;
+        got = static_cast<std::size_t>(n);
+        for (std::size_t i = 0; i < got; ++i)
+            handle_datagram(buf.data() + i * DATAGRAM_BYTES, msgs[i].msg_len, now);
+#else
+        while (got < batch)
+        {
+            ssize_t n = ::recv(fd_, buf.data(), DATAGRAM_BYTES, MSG_DONTWAIT);
+            if (n < 0) break;
+            handle_datagram(buf.data(), static_cast<std::size_t>(n), now);
+            ++got;
+        }
+        if (got == 0) continue;
+#endif
+
+        stats_.receive_calls.fetch_add(1, std::memory_order_relaxed);
+        bump_max(stats_.max_batch, got);
+    }
+}
+
+#else
+
+bool UdpReceiver::start()
+{
+    std::cerr << "udp: not supported on this platform\n";
+    return false;
+}
+
+void UdpReceiver::stop()
+{
+}
+
+void UdpReceiver::run()
+{
+}
+
+#endif
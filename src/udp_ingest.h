@@ -0,0 +1,76 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+
+#include "nmea.h"
+#include "spsc_queue.h"
+
+struct UdpIngestConfig
+{
+    std::uint16_t port{10110};          // NMEA-over-UDP convention
+    std::size_t batch{32};              // datagrams per recvmmsg call
+    std::size_t queue_capacity{16384};  // reports between the two threads
+    bool has_origin{false};             // own ship's position, needed for AIS
+    double origin_lat{0.0};
+    double origin_lon{0.0};
+};
+
+// Counters written by the receiver thread, readable from any thread.
+struct UdpIngestStats
+{
+    std::atomic<std::uint64_t> datagrams{0};
+    std::atomic<std::uint64_t> sentences{0};
+    std::atomic<std::uint64_t> decoded{0};
+    std::atomic<std::uint64_t> bad_checksum{0};
+    std::atomic<std::uint64_t> unsupported{0};
+    std::atomic<std::uint64_t> malformed{0};
+    std::atomic<std::uint64_t> no_origin{0};    // AIS without --ais-origin
+    std::atomic<std::uint64_t> dropped{0};      // queue full
+    std::atomic<std::uint64_t> receive_calls{0};
+    std::atomic<std::uint64_t> max_batch{0};    // datagrams in one call
+};
+
+// Network front end for the stream tracker.
+//
+// A dedicated thread receives NMEA datagrams on a UDP port (any interface),
+// several per system call (recvmmsg on Linux, a non-blocking recvfrom loop
+// elsewhere), decodes every sentence with an NmeaDecoder and pushes the
+// ContactReports into a single-producer / single-consumer queue. The
+// tracking thread drains queue(); when it falls behind and the queue is
+// full, new reports are dropped and counted rather than blocking the
+// socket. All buffers are allocated in start().
+class UdpReceiver
+{
+public:
+    explicit UdpReceiver(const UdpIngestConfig& cfg = UdpIngestConfig{});
+    ~UdpReceiver();
+
+    UdpReceiver(const UdpReceiver&) = delete;
+    UdpReceiver& operator=(const UdpReceiver&) = delete;
+
+    // Bind (port 0 picks a free one) and start the thread; false on error.
+    bool start();
+    void stop();
+
+    std::uint16_t port() const { return port_; }
+
+    SpscQueue<ContactReport>& queue() { return queue_; }
+    const UdpIngestStats& stats() const { return stats_; }
+
+private:
+    void run();
+    void handle_datagram(const char* data, std::size_t len, double recv_time);
+
+    UdpIngestConfig cfg_;
+    NmeaDecoder decoder_;
+    SpscQueue<ContactReport> queue_;
+    UdpIngestStats stats_;
+
+    std::thread thread_;
+    std::atomic<bool> stop_{false};
+    double midnight_{0.0};  // [s since epoch] UTC start of the day start() ran
+    int fd_{-1};
+    std::uint16_t port_{0};
+};
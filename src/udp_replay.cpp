@@ -0,0 +1,232 @@
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "io.h"
+#include "nmea.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#define CPA_HAVE_SOCKETS 1
+#endif
+
+// Whole-argument unsigned integer in [lo, hi]; rejects signs, spaces and
+// trailing characters, which atoi would quietly accept.
+static bool parse_count(const char* s, std::size_t lo, std::size_t hi, std::size_t& out)
+{
+    if (*s < '0' || *s > '9') return false;
+    errno = 0;
+    char* end = nullptr;
+    unsigned long long v = std::strtoull(s, &end, 10);
+    if (errno == ERANGE || *end != '\0' || v < lo || v > hi) return false;
+    out = static_cast<std::size_t>(v);
+    return true;
+}
+
+static void print_usage()
+{
+    std::cerr << "Usage: cpa_udp_replay <file> [--host ADDR] [--port P] [--speed X | --max]\n";
+    std::cerr << "\nSends a recording to cpa_risk --udp, one sentence per datagram.\n"
+              << "<file> is either a time-series CSV (time,id,x,y,speed,course), whose\n"
+              << "rows are sent in time order as $RATTM sentences, or an NMEA log with\n"
+              << "one sentence per line, optionally preceded by a time in seconds\n"
+              << "(\"12.5 !AIVDM,...\"); untimed lines go out with the previous one.\n"
+              << "AIS reports are dated by the receiver's clock, so replay them at --speed 1.\n"
+              << "\n--host ADDR  destination IPv4 address (default 127.0.0.1)\n"
+              << "--port P     destination port (default 10110)\n"
+              << "--speed X    replay X times faster than recorded (default 1)\n"
+              << "--max        send as fast as possible\n";
+}
+
+namespace
+{
+
+struct Timed
+{
+    double time;
+    std::string sentence;
+};
+
+bool load_csv(std::istream& in, std::vector<Timed>& out)
+{
+    std::unordered_map<std::string, int> numbers;
+    std::string line;
+    std::getline(in, line);  // header
+    while (std::getline(in, line))
+    {
+        if (line.empty()) continue;
+        MeasurementView m;
+        if (!parse_measurement_row(line, m)) continue;
+        auto it = numbers.emplace(std::string(m.id), static_cast<int>(numbers.size())).first;
+        out.push_back(Timed{ m.time, format_ttm(it->second, m.id, m.time, m.x, m.y,
+                                                m.speed, m.course_deg) });
+    }
+    std::stable_sort(out.begin(), out.end(),
+                     [](const Timed& a, const Timed& b) { return a.time < b.time; });
+    return true;
+}
+
+bool load_log(std::istream& in, std::vector<Timed>& out)
+{
+    std::string line;
+    double t = 0.0;
+    while (std::getline(in, line))
+    {
+        while (!line.empty() && (line.back() == '\r' || line.back() == ' ')) line.pop_back();
+        if (line.empty()) continue;
+        std::size_t start = 0;
+        if (line[0] != '$' && line[0] != '!' && line[0] != '\\')
+        {
+            char* end = nullptr;
+            t = std::strtod(line.c_str(), &end);
+            start = static_cast<std::size_t>(end - line.c_str());
+            while (start < line.size() && (line[start] == ' ' || line[start] == '\t' || line[start] == ','))
+                ++start;
+        }
+        if (start < line.size()) out.push_back(Timed{ t, line.substr(start) });
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    std::string path;
+    std::string host = "127.0.0.1";
+    int port = 10110;
+    double speed = 1.0;
+    bool max_rate = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--host" || arg == "--port" || arg == "--speed")
+        {
+            if (i + 1 >= argc)
+            {
+                std::cerr << arg << " requires a value\n";
+                return 1;
+            }
+            const char* v = argv[++i];
+            if (arg == "--host")
+            {
+                host = v;
+            }
+            else if (arg == "--port")
+            {
+                std::size_t p = 0;
+                if (!parse_count(v, 1, 65535, p))
+                {
+                    std::cerr << "--port must be between 1 and 65535\n";
+                    return 1;
+                }
+                port = static_cast<int>(p);
+            }
+            else
+            {
+                char* end = nullptr;
+                speed = std::strtod(v, &end);
+                if (end == v || *end != '\0' || !std::isfinite(speed) || speed <= 0.0)
+                {
+                    std::cerr << "--speed must be a number > 0\n";
+                    return 1;
+                }
+            }
+        }
+        else if (arg == "--max")
+            max_rate = true;
+        else if (arg.rfind("--", 0) == 0)
+        {
+            std::cerr << "Unknown option: " << arg << "\n";
+            print_usage();
+            return 1;
+        }
+        else if (path.empty())
+            path = arg;
+        else
+        {
+            std::cerr << "Unexpected extra argument: " << arg << "\n";
+            print_usage();
+            return 1;
+        }
+    }
+
+    if (path.empty() || port <= 0 || port > 65535 || !(speed > 0.0))
+    {
+        print_usage();
+        return 1;
+    }
+
+    std::ifstream in(path);
+    if (!in)
+    {
+        std::cerr << "Failed to open file: " << path << "\n";
+        return 1;
+    }
+    std::vector<Timed> out;
+    const bool csv = in.peek() == 't';  // "time,id,..."
+    if (csv) load_csv(in, out); else load_log(in, out);
+    if (out.empty())
+    {
+        std::cerr << "Nothing to send in " << path << "\n";
+        return 1;
+    }
+
+#ifdef CPA_HAVE_SOCKETS
+    int fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<std::uint16_t>(port));
+    if (fd < 0 || ::inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1)
+    {
+        std::cerr << "Bad destination " << host << ":" << port << "\n";
+        return 1;
+    }
+
+    using clock = std::chrono::steady_clock;
+    const auto t0 = clock::now();
+    const double first = out.front().time;
+    std::size_t sent = 0, failed = 0;
+
+    for (const Timed& s : out)
+    {
+        if (!max_rate)
+        {
+            auto due = t0 + std::chrono::duration_cast<clock::duration>(
+                std::chrono::duration<double>((s.time - first) / speed));
+            std::this_thread::sleep_until(due);
+        }
+        std::string dgram = s.sentence + "\r\n";
+        if (::sendto(fd, dgram.data(), dgram.size(), 0,
+                     reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0)
+            ++failed;
+        else
+            ++sent;
+    }
+    ::close(fd);
+
+    const double secs = std::chrono::duration<double>(clock::now() - t0).count();
+    std::cerr << "Sent " << sent << " sentences (" << (csv ? "TTM from CSV" : "NMEA log")
+              << ") to " << host << ":" << port << " in " << secs << " s";
+    if (secs > 0.0) std::cerr << ", " << static_cast<double>(sent) / secs << " /s";
+    std::cerr << "\n";
+    if (failed) std::cerr << failed << " sends failed\n";
+    return failed ? 1 : 0;
+#else
+    std::cerr << "UDP replay is not supported on this platform\n";
+    return 1;
+#endif
+}